@@ -1,34 +1,136 @@
+import os
+from typing import Optional
 from pydantic import BaseModel
-from fastapi import FastAPI
+from fastapi import FastAPI, HTTPException, Request, Response
+from fastapi.responses import JSONResponse
 import soundsift_index
+import ipc
+import tags
+from filters import FilterError, QueryFilters
 
 
 app = FastAPI()
 Index = soundsift_index.SoundSiftIndex()
+Ipc = ipc.IpcServer(Index, *ipc.default_paths())
+Ipc.start()
 
 class SampleFolder(BaseModel):
     file_path: str
+    # Also embed overlapping windows of files longer than one window
+    segments: bool = True
+
+class Library(BaseModel):
+    name: str
+    root: Optional[str] = None
 
 class Query(BaseModel):
     text: str
     top_k: int
+    filters: Optional[QueryFilters] = None
+    mode: str = "hybrid"  # or "semantic" for vector similarity only
+
+class TagQuery(BaseModel):
+    tag: Optional[str] = None  # /tags/top only
+    top_k: int = 50
+    filters: Optional[QueryFilters] = None
+
+@app.exception_handler(FilterError)
+async def filter_error(request: Request, exc: FilterError):
+    return JSONResponse(status_code=400, content={"detail": str(exc)})
 
+def server_timing(timings) -> str:
+    # Stage timings for the client's trace, in Server-Timing header format
+    return ", ".join(f"{name};dur={ms:.3f}" for name, ms in timings.items())
+
+# Plain def: FastAPI runs it on its thread pool, so the event loop stays
+# free to answer queries, which keep using the previous snapshot meanwhile
 @app.post("/index/folder")
-async def index(sample_folder: SampleFolder):
+def index(sample_folder: SampleFolder):
     try:
-        changed = Index.index_folder(sample_folder.file_path)
-        Index.loaded = False
+        changed = Index.index_folder(sample_folder.file_path, sample_folder.segments)
         return {'status': 'ok', 'files_embedded': changed}
-    except:
-        print('Failed')
-        return {'status': 'error', 'files_embedded': changed if changed else 0}
+    except Exception as e:
+        print(f'Failed: {e}')
+        return {'status': 'error', 'files_embedded': 0, 'error': str(e)}
 
 @app.post("/query/text")
-async def index(query: Query):
-    # Index.ensure_loaded()
-    results = Index.query(query.text, top_k=query.top_k)
-    return {"results": results}
+async def index(query: Query, response: Response):
+    timings = {}
+    with Index.lock:
+        Index.ensure_loaded()
+        results = Index.query(query.text, top_k=query.top_k, filters=query.filters,
+                              timings=timings, mode=query.mode)
+        version = Index.index_version()
+    response.headers["Server-Timing"] = server_timing(timings)
+    return {"results": results, "index_version": version}
+
+# Answered from the precomputed tag scores: no model call, no vector scan
+@app.get("/tags")
+async def tag_vocabulary():
+    return {"tags": [{"name": name, "prompt": prompt} for name, prompt in tags.TAGS]}
+
+@app.post("/tags/facets")
+async def tag_facets(query: TagQuery):
+    with Index.lock:
+        Index.ensure_loaded()
+        counts = Index.tag_facets(query.filters)
+        version = Index.index_version()
+    return {"tags": counts, "index_version": version}
+
+@app.post("/tags/top")
+async def tag_top(query: TagQuery):
+    with Index.lock:
+        Index.ensure_loaded()
+        results = Index.top_tagged(query.tag or "", top_k=query.top_k, filters=query.filters)
+        version = Index.index_version()
+    return {"results": results, "index_version": version}
+
+@app.post("/status")
+async def status():
+    return {
+        "status": "ok",
+        "data_dir": os.path.abspath(soundsift_index.DATA_DIR),
+        "suggestions": os.path.abspath(soundsift_index.SUGGEST_PATH),
+        "index_version": Index.index_version(),
+        "ready": Index.loaded,
+        "ipc": Ipc.describe(),
+        # Data directory of every mounted store, for the plugin to map its
+        # descriptors.bin sidecar
+        "stores": {
+            store.name: os.path.abspath(store.data_dir)
+            for store in Index.libraries.mounted()
+        },
+        # Exported text tower, when there is one, for in-process queries
+        "text_encoder": (
+            os.path.abspath(soundsift_index.TEXT_ENCODER_DIR)
+            if os.path.exists(os.path.join(soundsift_index.TEXT_ENCODER_DIR, "encoder.json")) else None
+        ),
+    }
+
+@app.get("/libraries")
+async def libraries():
+    return {"libraries": Index.libraries.describe()}
+
+@app.post("/libraries/register")
+async def register_library(library: Library):
+    try:
+        Index.libraries.register(library.name, library.root)
+    except ValueError as e:
+        raise HTTPException(status_code=400, detail=str(e))
+    return {"libraries": Index.libraries.describe()}
+
+@app.post("/libraries/unregister")
+async def unregister_library(library: Library):
+    Index.libraries.unregister(library.name)
+    return {"libraries": Index.libraries.describe()}
 
 @app.post("/load")
 async def load():
-    Index.ensure_loaded()
\ No newline at end of file
+    with Index.lock:
+        warmup = Index.ensure_loaded()
+    return {
+        "status": "ok",
+        "ready": Index.loaded,
+        "index_version": Index.index_version(),
+        "warmup": warmup,
+    }
@@ -1,16 +1,17 @@
 import sqlite3
 import os
+import time
 import numpy as np
 
 DB_PATH = "data/soundsift.db"
 
-def get_connection():
-    os.makedirs(os.path.dirname(DB_PATH), exist_ok=True)
-    return sqlite3.connect(DB_PATH)
+def get_connection(db_path: str = DB_PATH):
+    os.makedirs(os.path.dirname(db_path), exist_ok=True)
+    return sqlite3.connect(db_path)
 
 
-def init_db():
-    conn = get_connection()
+def init_db(db_path: str = DB_PATH):
+    conn = get_connection(db_path)
     cur = conn.cursor()
 
     cur.execute("""
@@ -19,10 +20,21 @@ def init_db():
         path TEXT UNIQUE,
         vec_index INTEGER,
         mtime REAL,
-        duration REAL
+        duration REAL,
+        indexed_at REAL
     )
     """)
 
+    # Older catalogs were created before indexed_at existed
+    cur.execute("PRAGMA table_info(samples)")
+    columns = {row[1] for row in cur.fetchall()}
+    if "indexed_at" not in columns:
+        cur.execute("ALTER TABLE samples ADD COLUMN indexed_at REAL")
+    # Their rows were indexed no later than the file's mtime says, so that
+    # stands in; NULL would drop them from every indexed_after filter.
+    # Unconditional, for catalogs migrated before the backfill existed.
+    cur.execute("UPDATE samples SET indexed_at = mtime WHERE indexed_at IS NULL")
+
     # cur.execute("""
     # CREATE TABLE IF NOT EXISTS embeddings (
     #     sample_id INTEGER,
@@ -54,8 +66,8 @@ def blob_to_np(blob: bytes, dim: int) -> np.ndarray:
     return np.frombuffer(blob, dtype=np.float32, count=dim)
 
 
-def get_sample_by_path(path: str):
-    conn = get_connection()
+def get_sample_by_path(path: str, db_path: str = DB_PATH):
+    conn = get_connection(db_path)
     cur = conn.cursor()
     cur.execute(
         "SELECT id, mtime FROM samples WHERE path = ?",
@@ -65,8 +77,8 @@ def get_sample_by_path(path: str):
     conn.close()
     return row
 
-def get_sample_by_index(idx: int):
-    conn = get_connection()
+def get_sample_by_index(idx: int, db_path: str = DB_PATH):
+    conn = get_connection(db_path)
     cur = conn.cursor()
     cur.execute(
         "SELECT id, path FROM samples WHERE vec_index = ?",
@@ -76,15 +88,28 @@ def get_sample_by_index(idx: int):
     conn.close()
     return row[1] if row else None
 
-def insert_sample(path: str, index: int, mtime: float, duration: float) -> bool:
+def get_catalog(db_path: str = DB_PATH):
+    """All catalog rows that have a vector, ordered by vec_index."""
+    conn = get_connection(db_path)
+    cur = conn.cursor()
+    cur.execute(
+        "SELECT vec_index, path, duration, indexed_at FROM samples "
+        "WHERE vec_index IS NOT NULL ORDER BY vec_index"
+    )
+    rows = cur.fetchall()
+    conn.close()
+    return rows
+
+def insert_sample(path: str, index: int, mtime: float, duration: float,
+                  db_path: str = DB_PATH) -> bool:
     try:
-        conn = get_connection()
+        conn = get_connection(db_path)
         cur = conn.cursor()
 
         cur.execute("""
-        INSERT INTO samples (path, vec_index, mtime, duration)
-        VALUES (?, ?, ?, ?)
-        """, (path, index, mtime, duration))
+        INSERT INTO samples (path, vec_index, mtime, duration, indexed_at)
+        VALUES (?, ?, ?, ?, ?)
+        """, (path, index, mtime, duration, time.time()))
 
         conn.commit()
         return True
@@ -97,6 +122,43 @@ def insert_sample(path: str, index: int, mtime: float, duration: float) -> bool:
 
     # return sample_id
 
+def insert_samples(rows, db_path: str = DB_PATH) -> bool:
+    """
+    Batched insert_sample: rows of (path, index, mtime, duration), all in
+    one transaction. A path already in the catalog keeps its row.
+    """
+    conn = get_connection(db_path)
+    try:
+        now = time.time()
+        with conn:
+            conn.executemany("""
+            INSERT OR IGNORE INTO samples (path, vec_index, mtime, duration, indexed_at)
+            VALUES (?, ?, ?, ?, ?)
+            """, [(path, index, mtime, duration, now) for path, index, mtime, duration in rows])
+        return True
+    except sqlite3.Error as e:
+        print(f"failed to insert {len(rows)} samples: {e}")
+        return False
+    finally:
+        conn.close()
+
+def delete_samples_from(vec_index: int, db_path: str = DB_PATH):
+    """Drops the rows of an index run that never published its vectors."""
+    conn = get_connection(db_path)
+    try:
+        with conn:
+            conn.execute("DELETE FROM samples WHERE vec_index >= ?", (int(vec_index),))
+    finally:
+        conn.close()
+
+def get_indexed_paths(db_path: str = DB_PATH) -> set:
+    conn = get_connection(db_path)
+    cur = conn.cursor()
+    cur.execute("SELECT path FROM samples")
+    paths = {row[0] for row in cur.fetchall()}
+    conn.close()
+    return paths
+
 def upsert_sample(path: str, mtime: float, duration: float) -> int:
     conn = get_connection()
     cur = conn.cursor()
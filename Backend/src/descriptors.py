@@ -0,0 +1,289 @@
+import os
+import struct
+from typing import Dict, Optional
+
+import numpy as np
+from numpy.lib.stride_tricks import sliding_window_view
+from scipy.signal import lfilter
+
+# -----------------------------
+# Config
+# -----------------------------
+
+DESCRIPTOR_VERSION = 1
+
+# Column order is the file format; append only
+COLUMNS = (
+    "peak_db",          # sample peak, dBFS
+    "rms_db",           # whole-file RMS, dBFS
+    "lufs",             # integrated loudness (BS.1770 K-weighting and gating)
+    "leading_silence",  # seconds before the signal first exceeds SILENCE_DB
+    "onset_count",
+    "centroid_hz",      # energy-weighted mean spectral centroid
+    "bpm",              # NaN when there aren't enough onsets to tell
+)
+
+HEADER_BYTES = 16
+NAME_BYTES = 16
+
+SILENCE_DB = -60.0
+FRAME = 2048
+HOP = 512
+MIN_BPM, MAX_BPM = 60.0, 200.0
+MIN_ONSETS_FOR_BPM = 4
+
+# Flux a peak must clear on top of 1.5x the local median, so steady tones
+# and noise beds don't count as onsets
+ONSET_FLOOR = 20.0
+
+# Analysis works through the file in pieces, so its scratch memory stays
+# a few MB however long the file: FFT frames per spectral chunk, and
+# seconds per loudness chunk
+CHUNK_FRAMES = 256
+CHUNK_SECONDS = 5.0
+
+
+# -----------------------------
+# Analysis
+# -----------------------------
+
+def to_db(x: float) -> float:
+    return float(20.0 * np.log10(max(x, 1e-10)))
+
+
+def k_weighting(sr: int):
+    """BS.1770 pre-filter (high shelf) and RLB high-pass for sr: ((b1, b2), (a1, a2))."""
+    # High shelf, +4 dB above ~1.7 kHz
+    f0, gain, q = 1681.974450955533, 3.999843853973347, 0.7071752369554196
+    k = np.tan(np.pi * f0 / sr)
+    vh = 10 ** (gain / 20.0)
+    vb = vh ** 0.4996667741545416
+    a0 = 1.0 + k / q + k * k
+    b1 = [(vh + vb * k / q + k * k) / a0, 2.0 * (k * k - vh) / a0, (vh - vb * k / q + k * k) / a0]
+    a1 = [1.0, 2.0 * (k * k - 1.0) / a0, (1.0 - k / q + k * k) / a0]
+
+    # High-pass at ~38 Hz
+    f0, q = 38.13547087602444, 0.5003270373238773
+    k = np.tan(np.pi * f0 / sr)
+    a0 = 1.0 + k / q + k * k
+    b2 = [1.0, -2.0, 1.0]
+    a2 = [1.0, 2.0 * (k * k - 1.0) / a0, (1.0 - k / q + k * k) / a0]
+
+    return (b1, b2), (a1, a2)
+
+
+def chunks(n: int, size: int):
+    """(start, stop) pairs covering range(n) in steps of size."""
+    for start in range(0, n, size):
+        yield start, min(start + size, n)
+
+
+def integrated_lufs(audio: np.ndarray, sr: int) -> float:
+    # Filtered CHUNK_SECONDS at a time, carrying the filter state, and
+    # reduced to the energy of each 100 ms step; a 400 ms block is four
+    # steps. float64 only ever for one chunk, not the whole file.
+    step = int(0.1 * sr)
+    block = 4 * step
+    chunk = step * max(1, int(CHUNK_SECONDS / 0.1))
+    b, a = k_weighting(sr)
+    state = [np.zeros(len(a_) - 1) for a_ in a]
+
+    steps = np.empty(len(audio) // step, dtype=np.float64)
+    total = 0.0
+    for start, stop in chunks(len(audio), chunk):
+        weighted = audio[start:stop].astype(np.float64)
+        for i, (b_, a_) in enumerate(zip(b, a)):
+            weighted, state[i] = lfilter(b_, a_, weighted, zi=state[i])
+        squared = weighted * weighted
+        total += float(squared.sum())
+        full = (stop - start) // step  # chunk is a whole number of steps, bar the last
+        steps[start // step:start // step + full] = squared[:full * step].reshape(full, step).sum(axis=1)
+
+    if len(audio) < block:
+        # Shorter than one gating block: ungated mean square
+        power = total / len(audio) if len(audio) else 0.0
+        return -0.691 + 10.0 * np.log10(max(power, 1e-12))
+
+    # Mean square of every 400 ms block at 75 % overlap
+    power = sliding_window_view(steps, 4).sum(axis=1) / block
+    loudness = -0.691 + 10.0 * np.log10(np.maximum(power, 1e-12))
+
+    gated = power[loudness > -70.0]
+    if len(gated) == 0:
+        return float("-inf")
+    relative = -0.691 + 10.0 * np.log10(np.mean(gated)) - 10.0
+    gated = power[(loudness > -70.0) & (loudness > relative)]
+    return float(-0.691 + 10.0 * np.log10(np.mean(gated))) if len(gated) else float("-inf")
+
+
+def spectral_envelope(audio: np.ndarray, sr: int):
+    """
+    Half-wave rectified log-spectral flux per hop, and the energy-weighted
+    mean spectral centroid. Frames are transformed CHUNK_FRAMES at a time
+    with running sums, so a long file costs a few MB rather than a
+    spectrogram of itself.
+    """
+    if len(audio) < FRAME:
+        audio = np.pad(audio, (0, FRAME - len(audio)))
+    n_frames = (len(audio) - FRAME) // HOP + 1
+    window = np.hanning(FRAME).astype(np.float32)
+    freqs = np.fft.rfftfreq(FRAME, 1.0 / sr).astype(np.float32)
+
+    flux = np.zeros(n_frames, dtype=np.float64)
+    weighted, energy = 0.0, 0.0
+    previous = None
+    for start, stop in chunks(n_frames, CHUNK_FRAMES):
+        span = audio[start * HOP:(stop - 1) * HOP + FRAME]
+        frames = sliding_window_view(span, FRAME)[::HOP] * window
+        mags = np.abs(np.fft.rfft(frames, axis=1)).astype(np.float32)
+        log_mags = np.log1p(100.0 * mags)
+        if previous is not None:  # the last frame of the chunk before
+            log_mags = np.concatenate([previous, log_mags])
+        flux[stop - len(log_mags) + 1:stop] = np.maximum(np.diff(log_mags, axis=0), 0.0).sum(axis=1)
+        previous = log_mags[-1:]
+
+        # Per-frame centroids weighted by frame energy reduce to this ratio
+        weighted += float((mags @ freqs).sum(dtype=np.float64))
+        energy += float(mags.sum(dtype=np.float64))
+
+    centroid = weighted / energy if energy > 0 else float("nan")
+    return flux, centroid
+
+
+def pick_onsets(flux: np.ndarray) -> np.ndarray:
+    """Local maxima well above the moving median."""
+    if len(flux) < 3:
+        return np.empty(0, dtype=np.int64)
+    width = 9
+    padded = np.pad(flux, width // 2, mode="edge")
+    local_median = np.median(sliding_window_view(padded, width), axis=1)
+    threshold = 1.5 * local_median + ONSET_FLOOR
+    peaks = (flux[1:-1] > flux[:-2]) & (flux[1:-1] >= flux[2:]) & (flux[1:-1] > threshold[1:-1])
+    return np.flatnonzero(peaks) + 1
+
+
+def estimate_bpm(flux: np.ndarray, sr: int) -> float:
+    """Tempo from the autocorrelation peak of the onset envelope."""
+    frame_rate = sr / HOP
+    env = flux - flux.mean()
+    n = len(env)
+    spectrum = np.fft.rfft(env, 2 * n)
+    acf = np.fft.irfft(spectrum * np.conj(spectrum))[:n]
+
+    lo = int(frame_rate * 60.0 / MAX_BPM)
+    hi = min(int(frame_rate * 60.0 / MIN_BPM) + 1, n)
+    if hi <= lo + 1:
+        return float("nan")
+
+    lag = lo + int(np.argmax(acf[lo:hi]))
+    # Parabolic interpolation around the peak for sub-frame lag
+    if lo < lag < hi - 1:
+        a, b, c = acf[lag - 1], acf[lag], acf[lag + 1]
+        denom = a - 2.0 * b + c
+        if denom != 0.0:
+            lag = lag + 0.5 * (a - c) / denom
+    return float(60.0 * frame_rate / lag)
+
+
+def analyse(audio: np.ndarray, sr: int) -> Dict[str, float]:
+    """All descriptor columns for one mono signal."""
+    audio = np.asarray(audio, dtype=np.float32)
+    if len(audio) == 0:
+        return {name: float("nan") for name in COLUMNS}
+
+    peak = float(max(audio.max(), -audio.min()))
+    square_sum, first = 0.0, len(audio)
+    chunk = max(1, int(CHUNK_SECONDS * sr))
+    for start, stop in chunks(len(audio), chunk):
+        piece = audio[start:stop].astype(np.float64)
+        square_sum += float(np.dot(piece, piece))
+        if first == len(audio):
+            above = np.flatnonzero(np.abs(piece) > 10 ** (SILENCE_DB / 20.0))
+            if len(above):
+                first = start + int(above[0])
+
+    flux, centroid = spectral_envelope(audio, sr)
+    onsets = pick_onsets(flux)
+
+    bpm = estimate_bpm(flux, sr) if len(onsets) >= MIN_ONSETS_FOR_BPM else float("nan")
+
+    return {
+        "peak_db": to_db(peak),
+        "rms_db": to_db(float(np.sqrt(square_sum / len(audio)))),
+        "lufs": integrated_lufs(audio, sr),
+        "leading_silence": first / sr,
+        "onset_count": float(len(onsets)),
+        "centroid_hz": centroid,
+        "bpm": bpm,
+    }
+
+
+# -----------------------------
+# Sidecar
+# -----------------------------
+
+def header_bytes() -> int:
+    return HEADER_BYTES + NAME_BYTES * len(COLUMNS)
+
+
+def write_descriptors(out_path: str, table: np.ndarray):
+    """
+    descriptors.bin: "SSDC", uint32 version, uint32 rows, uint32 columns,
+    one 16-byte column name each, then every column as rows float32
+    values back to back. Read natively by the plugin (DescriptorTable.h).
+    """
+    n_rows = table.shape[1]
+    temp_path = out_path + ".tmp"
+    with open(temp_path, "wb") as f:
+        f.write(b"SSDC")
+        f.write(struct.pack("<III", DESCRIPTOR_VERSION, n_rows, len(COLUMNS)))
+        for name in COLUMNS:
+            f.write(name.encode("ascii").ljust(NAME_BYTES, b"\0"))
+        f.write(np.ascontiguousarray(table, dtype="<f4").tobytes())
+    os.replace(temp_path, out_path)
+
+
+class DescriptorTable:
+    """
+    Memory-mapped view of descriptors.bin; column(name) is a float32 array
+    indexed by vec_index. Rows the analyser hasn't seen read as NaN.
+    """
+
+    def __init__(self, path: str, n_rows: int):
+        self.n_rows = n_rows
+        self.columns: Dict[str, np.ndarray] = {}
+
+        if os.path.exists(path) and os.path.getsize(path) >= header_bytes():
+            with open(path, "rb") as f:
+                magic, version, rows, cols = struct.unpack("<4sIII", f.read(HEADER_BYTES))
+            if magic == b"SSDC" and version == DESCRIPTOR_VERSION and cols == len(COLUMNS):
+                data = np.memmap(path, dtype="<f4", mode="r", offset=header_bytes(),
+                                 shape=(cols, rows))
+                for i, name in enumerate(COLUMNS):
+                    self.columns[name] = data[i]
+
+    def column(self, name: str) -> np.ndarray:
+        col = self.columns.get(name)
+        if col is None or len(col) < self.n_rows:
+            full = np.full(self.n_rows, np.nan, dtype=np.float32)
+            if col is not None:
+                full[:len(col)] = col
+            return full
+        return col[:self.n_rows]
+
+    def grown(self, n_rows: int) -> np.ndarray:
+        """Copy of every column resized to n_rows, new rows NaN."""
+        table = np.full((len(COLUMNS), n_rows), np.nan, dtype=np.float32)
+        for i, name in enumerate(COLUMNS):
+            col = self.columns.get(name)
+            if col is not None:
+                n = min(len(col), n_rows)
+                table[i, :n] = col[:n]
+        return table
+
+    def row(self, vec_index: int) -> Optional[Dict[str, float]]:
+        if not self.columns or not 0 <= vec_index < len(self.columns[COLUMNS[0]]):
+            return None
+        # Non-finite values become None, which JSON can carry
+        values = {name: float(self.columns[name][vec_index]) for name in COLUMNS}
+        return {name: v if np.isfinite(v) else None for name, v in values.items()}
@@ -0,0 +1,216 @@
+"""
+Exports the CLAP text tower for in-process query encoding.
+
+Traces the RoBERTa text branch and projection of the checkpoint the index
+uses to ONNX, quantises the weights to int8, and writes it next to the
+tokenizer files and a manifest under data/text_encoder. The plugin (and
+SoundSiftQuery --local) load that directory with ONNX Runtime on the CPU,
+so a text query no longer needs the server or a Python start-up.
+
+The quantised model is checked against CLAP_Module.get_text_embedding on
+a fixed set of queries; the export fails if any cosine drops below
+--min-cosine. The token ids of the same queries go into the manifest, and
+the plugin refuses the model if its tokenizer disagrees with any of them.
+Re-run it whenever MODEL_VERSION changes.
+
+    python export_text_encoder.py
+    python export_text_encoder.py --out /tmp/text_encoder --keep-fp32
+"""
+import argparse
+import json
+import os
+import sys
+import time
+
+import numpy as np
+import torch
+import torch.nn.functional as F
+import laion_clap
+
+from soundsift_index import EMBED_DIM, MODEL_VERSION, TEXT_ENCODER_DIR
+
+# -----------------------------
+# Config
+# -----------------------------
+
+MANIFEST_VERSION = 2  # 2: token_checks
+MANIFEST_NAME = "encoder.json"
+MODEL_NAME = "text_encoder.int8.onnx"
+FP32_NAME = "text_encoder.onnx"
+MAX_LENGTH = 77  # CLAP_Module.tokenizer pads and truncates to this
+OPSET = 17
+DEFAULT_MIN_COSINE = 0.98
+LATENCY_RUNS = 50
+
+CHECK_QUERIES = [
+    "kick",
+    "punchy kick drum with a long tail",
+    "dusty vinyl crackle",
+    "bright hi-hat loop 120 bpm",
+    "deep sub bass hit",
+    "female vocal chop, reverb, airy",
+    "glass breaking",
+    "808 cowbell",
+    "warm analog pad with slow attack",
+    "snare roll building up to a drop",
+    "rain on a tin roof",
+    "distorted guitar power chord",
+]
+
+
+# -----------------------------
+# Model
+# -----------------------------
+
+class TextTower(torch.nn.Module):
+    """input_ids, attention_mask -> unit embedding, as CLAP_Module.get_text_embedding."""
+
+    def __init__(self, clap: laion_clap.CLAP_Module):
+        super().__init__()
+        self.branch = clap.model.text_branch
+        self.projection = clap.model.text_projection
+
+    def forward(self, input_ids, attention_mask):
+        pooled = self.branch(input_ids=input_ids, attention_mask=attention_mask)["pooler_output"]
+        return F.normalize(self.projection(pooled), dim=-1)
+
+
+def tokenize(clap: laion_clap.CLAP_Module, texts):
+    # Padded to the longest query rather than MAX_LENGTH, as the plugin
+    # does; masked positions do not change the pooled output
+    return clap.tokenize(texts, padding=True, truncation=True, max_length=MAX_LENGTH, return_tensors="np")
+
+
+def export(clap: laion_clap.CLAP_Module, path: str):
+    tower = TextTower(clap).eval()
+    sample = tokenize(clap, CHECK_QUERIES[:2])
+    args = (torch.from_numpy(sample["input_ids"]), torch.from_numpy(sample["attention_mask"]))
+
+    with torch.no_grad():
+        torch.onnx.export(
+            tower, args, path,
+            input_names=["input_ids", "attention_mask"],
+            output_names=["embedding"],
+            dynamic_axes={
+                "input_ids": {0: "batch", 1: "tokens"},
+                "attention_mask": {0: "batch", 1: "tokens"},
+                "embedding": {0: "batch"},
+            },
+            opset_version=OPSET,
+            do_constant_folding=True,
+            dynamo=False,
+        )
+
+
+# -----------------------------
+# Check
+# -----------------------------
+
+def run_session(session, clap, texts) -> np.ndarray:
+    tokens = tokenize(clap, texts)
+    feeds = {
+        "input_ids": tokens["input_ids"].astype(np.int64),
+        "attention_mask": tokens["attention_mask"].astype(np.int64),
+    }
+    return session.run(["embedding"], feeds)[0]
+
+
+def check(clap, session) -> dict:
+    reference = np.asarray(clap.get_text_embedding(CHECK_QUERIES), dtype=np.float32)
+    exported = run_session(session, clap, CHECK_QUERIES)
+    cosines = np.sum(reference * exported, axis=1) / (
+        np.linalg.norm(reference, axis=1) * np.linalg.norm(exported, axis=1))
+
+    run_session(session, clap, ["warm up"])
+    timings = []
+    for i in range(LATENCY_RUNS):
+        start = time.perf_counter()
+        run_session(session, clap, [CHECK_QUERIES[i % len(CHECK_QUERIES)]])
+        timings.append((time.perf_counter() - start) * 1000.0)
+
+    return {
+        "min_cosine": float(cosines.min()),
+        "mean_cosine": float(cosines.mean()),
+        "worst_query": CHECK_QUERIES[int(np.argmin(cosines))],
+        "latency_ms_p50": float(np.percentile(timings, 50)),
+    }
+
+
+# -----------------------------
+# CLI
+# -----------------------------
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("--out", default=TEXT_ENCODER_DIR, help="output directory (default %(default)s)")
+    parser.add_argument("--min-cosine", type=float, default=DEFAULT_MIN_COSINE,
+                        help="fail if int8 and PyTorch embeddings disagree more than this")
+    parser.add_argument("--keep-fp32", action="store_true", help="keep the unquantised model alongside")
+    args = parser.parse_args(argv)
+
+    try:
+        import onnxruntime as ort
+        from onnxruntime.quantization import QuantType, quantize_dynamic
+    except ImportError:
+        sys.exit("export_text_encoder needs onnx and onnxruntime: pip install onnx onnxruntime")
+
+    os.makedirs(args.out, exist_ok=True)
+    fp32_path = os.path.join(args.out, FP32_NAME)
+    model_path = os.path.join(args.out, MODEL_NAME)
+
+    clap = laion_clap.CLAP_Module(enable_fusion=False)
+    clap.load_ckpt()
+    clap.eval()
+
+    start = time.time()
+    export(clap, fp32_path)
+    quantize_dynamic(fp32_path, model_path + ".tmp", weight_type=QuantType.QInt8, per_channel=True)
+    os.replace(model_path + ".tmp", model_path)
+    if not args.keep_fp32:
+        os.remove(fp32_path)
+
+    # vocab.json and merges.txt: the byte-level BPE the plugin reimplements
+    clap.tokenize.save_vocabulary(args.out)
+
+    session = ort.InferenceSession(model_path, providers=["CPUExecutionProvider"])
+    report = check(clap, session)
+
+    tokenizer = clap.tokenize
+    manifest = {
+        "version": MANIFEST_VERSION,
+        "model": MODEL_NAME,
+        "vocab": "vocab.json",
+        "merges": "merges.txt",
+        "max_length": MAX_LENGTH,
+        "dim": EMBED_DIM,
+        "bos_id": tokenizer.bos_token_id,
+        "eos_id": tokenizer.eos_token_id,
+        "pad_id": tokenizer.pad_token_id,
+        "unk_id": tokenizer.unk_token_id,
+        "model_version": MODEL_VERSION,
+        "min_cosine": report["min_cosine"],
+        # clap.tokenize's ids, <s> and </s> included, for the plugin's
+        # BpeTokenizer to reproduce before it is trusted with queries
+        "token_checks": [
+            {"text": text, "ids": [int(i) for i in tokenizer(text, truncation=True, max_length=MAX_LENGTH)["input_ids"]]}
+            for text in CHECK_QUERIES
+        ],
+    }
+
+    if report["min_cosine"] < args.min_cosine:
+        sys.exit(f"int8 model drifts too far: cosine {report['min_cosine']:.4f} on "
+                 f"{report['worst_query']!r} (need {args.min_cosine}); manifest not written")
+
+    # The manifest goes last: /status only advertises a complete directory
+    manifest_path = os.path.join(args.out, MANIFEST_NAME)
+    with open(manifest_path + ".tmp", "w") as f:
+        json.dump(manifest, f, indent=2)
+    os.replace(manifest_path + ".tmp", manifest_path)
+
+    print(f"exported {model_path} ({os.path.getsize(model_path) / 1e6:.1f} MB) in {time.time() - start:.1f} s")
+    print(f"cosine vs PyTorch: min {report['min_cosine']:.4f}, mean {report['mean_cosine']:.4f}; "
+          f"single query {report['latency_ms_p50']:.1f} ms p50")
+
+
+if __name__ == "__main__":
+    main()
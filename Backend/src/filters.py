@@ -0,0 +1,190 @@
+import os
+from datetime import datetime
+from typing import Dict, List, Optional
+
+import numpy as np
+from pydantic import BaseModel
+
+from db import DB_PATH, get_catalog
+from descriptors import COLUMNS as DESCRIPTOR_COLUMNS, DescriptorTable
+from tags import NAMES as TAG_NAMES, POPCOUNT, TagTable
+
+# -----------------------------
+# Query filters
+# -----------------------------
+
+class QueryFilters(BaseModel):
+    min_duration: Optional[float] = None
+    max_duration: Optional[float] = None
+    folder: Optional[str] = None
+    extensions: Optional[List[str]] = None
+    indexed_after: Optional[str] = None  # ISO date or unix seconds
+    # [lo, hi] ranges over descriptor columns, either end None,
+    # e.g. {"bpm": [118, 122], "lufs": [None, -14]}
+    descriptors: Optional[Dict[str, List[Optional[float]]]] = None
+    # Zero-shot tags (tags.NAMES) a sample must all carry, e.g. ["snare"]
+    tags: Optional[List[str]] = None
+    # Not a filter: orders the returned top-k by a descriptor column,
+    # descending with a leading "-" ("bpm", "-lufs")
+    sort_by: Optional[str] = None
+
+
+class FilterError(ValueError):
+    """A filter the caller got wrong; the API answers it with a 400."""
+
+
+def parse_timestamp(value: str) -> float:
+    try:
+        return float(value)
+    except ValueError:
+        pass
+    try:
+        return datetime.fromisoformat(value).timestamp()
+    except ValueError:
+        raise FilterError(f"indexed_after: {value!r} is neither unix seconds nor an ISO date")
+
+
+# -----------------------------
+# Catalog columns
+# -----------------------------
+
+class Catalog:
+    """
+    Column view of the samples table, laid out by vec_index so that a
+    predicate evaluates to one bit per row of the embedding store.
+    Predicate bitmaps are kept packed (1 bit per row) and cached, so a
+    repeated filter costs an AND over a few KB instead of a DB query.
+    """
+
+    def __init__(self, n_rows: int, db_path: str = DB_PATH,
+                 descriptors_path: Optional[str] = None, tags_path: Optional[str] = None):
+        self.n_rows = n_rows
+        self.paths = np.full(n_rows, None, dtype=object)
+        self.duration = np.full(n_rows, np.nan, dtype=np.float32)
+        self.indexed_at = np.full(n_rows, np.nan, dtype=np.float64)
+        self.bitmaps: Dict[tuple, np.ndarray] = {}
+
+        for vec_index, path, duration, indexed_at in get_catalog(db_path):
+            if not 0 <= vec_index < n_rows:
+                continue
+            self.paths[vec_index] = path
+            if duration is not None:
+                self.duration[vec_index] = duration
+            if indexed_at is not None:
+                self.indexed_at[vec_index] = indexed_at
+
+        # Memory-mapped; columns are only paged in when a filter reads them
+        self.descriptors = DescriptorTable(descriptors_path or "", n_rows)
+        self.tags = TagTable(tags_path or "", n_rows)
+
+    def _cached(self, key: tuple, build) -> np.ndarray:
+        bitmap = self.bitmaps.get(key)
+        if bitmap is None:
+            bitmap = np.packbits(build())
+            self.bitmaps[key] = bitmap
+        return bitmap
+
+    def valid(self) -> np.ndarray:
+        return self._cached(("valid",), lambda: self.paths != None)  # noqa: E711
+
+    def duration_range(self, lo: Optional[float], hi: Optional[float]) -> np.ndarray:
+        def build():
+            mask = ~np.isnan(self.duration)
+            if lo is not None:
+                mask &= self.duration >= lo
+            if hi is not None:
+                mask &= self.duration <= hi
+            return mask
+        return self._cached(("duration", lo, hi), build)
+
+    def folder(self, folder: str) -> np.ndarray:
+        # Absolute folders match as a path prefix, bare names match any
+        # directory component ("Drums" matches ".../Drums/...").
+        if os.path.isabs(folder):
+            prefix = os.path.join(os.path.normpath(folder), "")
+            match = lambda p: p.startswith(prefix)
+        else:
+            part = os.sep + folder.strip(os.sep).lower() + os.sep
+            match = lambda p: part in p.lower()
+
+        def build():
+            return np.fromiter(
+                (p is not None and match(p) for p in self.paths),
+                dtype=bool, count=self.n_rows
+            )
+        return self._cached(("folder", folder), build)
+
+    def extensions(self, exts: List[str]) -> np.ndarray:
+        wanted = tuple(sorted("." + e.lower().lstrip(".") for e in exts))
+
+        def build():
+            return np.fromiter(
+                (p is not None and os.path.splitext(p)[1].lower() in wanted
+                 for p in self.paths),
+                dtype=bool, count=self.n_rows
+            )
+        return self._cached(("ext",) + wanted, build)
+
+    def indexed_after(self, when: float) -> np.ndarray:
+        return self._cached(("indexed_after", when),
+                            lambda: self.indexed_at >= when)
+
+    def descriptor_range(self, name: str, lo: Optional[float], hi: Optional[float]) -> np.ndarray:
+        def build():
+            col = self.descriptors.column(name)
+            mask = ~np.isnan(col)
+            if lo is not None:
+                mask &= col >= lo
+            if hi is not None:
+                mask &= col <= hi
+            return mask
+        return self._cached(("descriptor", name, lo, hi), build)
+
+    def tag(self, name: str) -> np.ndarray:
+        return self._cached(("tag", name), lambda: self.tags.tagged(name))
+
+    def tag_counts(self, bitmap: Optional[np.ndarray]) -> np.ndarray:
+        """Rows carrying each tag among bitmap's (every row when None), in TAG_NAMES order."""
+        base = self.valid() if bitmap is None else bitmap
+        return np.array([POPCOUNT[np.bitwise_and(base, self.tag(name))].sum() for name in TAG_NAMES],
+                        dtype=np.int64)
+
+    # ---------- COMPILE ----------
+
+    def compile(self, filters: Optional[QueryFilters]) -> Optional[np.ndarray]:
+        """
+        AND the predicate bitmaps together. Returns None when the query is
+        unfiltered so the caller can take the full-scan path.
+        """
+        if filters is None:
+            return None
+
+        parts = []
+        if filters.min_duration is not None or filters.max_duration is not None:
+            parts.append(self.duration_range(filters.min_duration, filters.max_duration))
+        if filters.folder:
+            parts.append(self.folder(filters.folder))
+        if filters.extensions:
+            parts.append(self.extensions(filters.extensions))
+        if filters.indexed_after:
+            parts.append(self.indexed_after(parse_timestamp(filters.indexed_after)))
+        for name, bounds in (filters.descriptors or {}).items():
+            if name in DESCRIPTOR_COLUMNS:
+                lo, hi = (list(bounds) + [None, None])[:2]
+                parts.append(self.descriptor_range(name, lo, hi))
+        for name in filters.tags or []:
+            if name not in TAG_NAMES:
+                # Dropping it would answer "tag:snares" with everything
+                raise FilterError(f"tags: unknown tag {name!r}")
+            parts.append(self.tag(name))
+
+        if not parts:
+            return None
+
+        bitmap = self.valid().copy()
+        for p in parts:
+            np.bitwise_and(bitmap, p, out=bitmap)
+        return bitmap
+
+    def rows(self, bitmap: np.ndarray) -> np.ndarray:
+        return np.flatnonzero(np.unpackbits(bitmap, count=self.n_rows))
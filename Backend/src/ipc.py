@@ -0,0 +1,268 @@
+import json
+import mmap
+import os
+import socket
+import struct
+import tempfile
+import threading
+import time
+from typing import Optional
+
+import numpy as np
+
+from filters import FilterError, QueryFilters
+from soundsift_index import EMBED_DIM
+
+# -----------------------------
+# Config
+# -----------------------------
+
+IPC_VERSION = 2
+MAX_RESULTS = 64
+MAX_SLOTS = 16
+PATH_BYTES = 64 * 1024
+# Requests are a query and its filters; anything bigger is a broken or
+# hostile client, not a reason to allocate what it announces
+MAX_MESSAGE_BYTES = 1 << 20
+
+FILE_HEADER_BYTES = 64
+SLOT_HEADER_BYTES = 16
+
+RECORD_DTYPE = np.dtype([
+    ("score", "<f4"),
+    ("similarity", "<f4"),
+    ("id", "<i4"),
+    ("library", "<u2"),
+    ("pad", "<u2"),
+    ("path_offset", "<u4"),
+    ("path_length", "<u4"),
+    ("offset", "<f4"),     # seconds into the file of the best window
+])
+
+VECTORS_OFFSET = SLOT_HEADER_BYTES + MAX_RESULTS * RECORD_DTYPE.itemsize
+PATHS_OFFSET = VECTORS_OFFSET + MAX_RESULTS * EMBED_DIM * 4
+SLOT_BYTES = PATHS_OFFSET + PATH_BYTES
+
+
+def default_paths():
+    base = os.path.join(tempfile.gettempdir(), f"soundsift-{os.getuid()}")
+    return base + ".sock", base + ".shm"
+
+
+# -----------------------------
+# Framing
+# -----------------------------
+
+def recv_exact(conn: socket.socket, n: int) -> Optional[bytes]:
+    buf = bytearray()
+    while len(buf) < n:
+        chunk = conn.recv(n - len(buf))
+        if not chunk:
+            return None
+        buf.extend(chunk)
+    return bytes(buf)
+
+
+def recv_message(conn: socket.socket):
+    header = recv_exact(conn, 4)
+    if header is None:
+        return None
+    length = struct.unpack("<I", header)[0]
+    if length > MAX_MESSAGE_BYTES:
+        raise ValueError(f"message of {length} bytes exceeds {MAX_MESSAGE_BYTES}")
+    body = recv_exact(conn, length)
+    return None if body is None else json.loads(body)
+
+
+def send_message(conn: socket.socket, message):
+    body = json.dumps(message).encode("utf-8")
+    conn.sendall(struct.pack("<I", len(body)) + body)
+
+
+# -----------------------------
+# Server
+# -----------------------------
+
+class IpcServer:
+    """
+    Same-machine transport for queries, next to the HTTP API. Control
+    messages are length-prefixed JSON over a Unix domain socket; results
+    go into a shared-memory file the plugin maps (IpcTransport.h), so a
+    reply is a few dozen bytes no matter how many results it carries.
+
+    Shared file layout (little endian):
+      header, 64 bytes: "SSSM", uint32 version, slot count, slot bytes,
+                        max results, dim, path bytes
+      slots[slot count], one per connection:
+        uint32 count, uint32 path bytes used, 8 bytes pad
+        records[max results]          RECORD_DTYPE
+        vectors[max results][dim]     float32
+        char[path bytes]              UTF-8 paths
+
+    A connection owns its slot and has one request in flight, so the
+    client reads the slot after the reply without further locking.
+    """
+
+    def __init__(self, index, socket_path: str, shm_path: str):
+        self.index = index
+        self.socket_path = socket_path
+        self.shm_path = shm_path
+        self.free_slots = list(range(MAX_SLOTS))
+        self.slot_lock = threading.Lock()
+        self.shm = None
+        self.listener = None
+
+    def start(self) -> bool:
+        if not hasattr(socket, "AF_UNIX"):
+            return False
+
+        try:
+            # Both live in the shared temp dir and carry result paths and
+            # vectors: owner-only, and created fresh rather than reusing
+            # whatever sits at the path
+            if os.path.lexists(self.shm_path):
+                os.remove(self.shm_path)
+            fd = os.open(self.shm_path, os.O_CREAT | os.O_EXCL | os.O_RDWR | getattr(os, "O_NOFOLLOW", 0), 0o600)
+            with os.fdopen(fd, "r+b") as f:
+                f.truncate(FILE_HEADER_BYTES + MAX_SLOTS * SLOT_BYTES)
+                self.shm = mmap.mmap(f.fileno(), 0)
+            self.shm[:28] = b"SSSM" + struct.pack(
+                "<6I", IPC_VERSION, MAX_SLOTS, SLOT_BYTES, MAX_RESULTS, EMBED_DIM, PATH_BYTES)
+
+            if os.path.exists(self.socket_path):
+                os.remove(self.socket_path)
+            self.listener = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+            umask = os.umask(0o177)
+            try:
+                self.listener.bind(self.socket_path)
+            finally:
+                os.umask(umask)
+            os.chmod(self.socket_path, 0o600)
+            self.listener.listen(MAX_SLOTS)
+        except OSError as e:
+            print(f"IPC transport disabled: {e}")
+            self.listener = None
+            return False
+
+        threading.Thread(target=self._accept, daemon=True).start()
+        return True
+
+    def describe(self):
+        if self.listener is None:
+            return None
+        return {"socket": self.socket_path, "shm": self.shm_path}
+
+    def _accept(self):
+        while True:
+            conn, _ = self.listener.accept()
+            threading.Thread(target=self._serve, args=(conn,), daemon=True).start()
+
+    def _serve(self, conn: socket.socket):
+        with self.slot_lock:
+            slot = self.free_slots.pop() if self.free_slots else None
+
+        try:
+            while True:
+                message = recv_message(conn)
+                if message is None:
+                    break
+                try:
+                    reply = self._handle(message, slot)
+                except FilterError as e:
+                    # Worded for the user, as the HTTP API's 400 detail
+                    reply = {"ok": False, "error": str(e)}
+                except (KeyError, TypeError, ValueError) as e:
+                    # A malformed request, not a broken connection
+                    reply = {"ok": False, "error": f"bad request: {e!r}"}
+                send_message(conn, reply)
+        except (OSError, ValueError) as e:
+            print(f"IPC connection closed: {e}")
+        finally:
+            conn.close()
+            if slot is not None:
+                with self.slot_lock:
+                    self.free_slots.append(slot)
+
+    def _handle(self, message, slot: Optional[int]):
+        if not isinstance(message, dict):
+            return {"ok": False, "error": "expected an object"}
+        op = message.get("op")
+
+        if slot is None:
+            return {"ok": False, "error": "no free slot"}
+
+        if op == "hello":
+            return {
+                "ok": True,
+                "version": IPC_VERSION,
+                "slot": slot,
+                "offset": FILE_HEADER_BYTES + slot * SLOT_BYTES,
+            }
+
+        if op == "query":
+            args = message.get("args") or {}
+            filters = args.get("filters")
+            timings = {}
+
+            if not isinstance(args.get("text"), str):
+                return {"ok": False, "error": "query needs a text string"}
+
+            with self.index.lock:
+                self.index.ensure_loaded()
+                results = self.index.query(
+                    args["text"],
+                    top_k=min(int(args.get("top_k", 10)), MAX_RESULTS),
+                    filters=QueryFilters(**filters) if filters else None,
+                    timings=timings,
+                    mode=args.get("mode", "hybrid"),
+                )
+                t0 = time.perf_counter()
+                count, libraries = self._write_slot(slot, results)
+                timings["shm"] = (time.perf_counter() - t0) * 1000.0
+                version = self.index.index_version()
+
+            return {
+                "ok": True,
+                "count": count,
+                "libraries": libraries,
+                "index_version": version,
+                "timings": timings,
+            }
+
+        return {"ok": False, "error": f"unknown op {op!r}"}
+
+    def _write_slot(self, slot: int, results):
+        base = FILE_HEADER_BYTES + slot * SLOT_BYTES
+        records = np.zeros(len(results), dtype=RECORD_DTYPE)
+        vectors = np.zeros((len(results), EMBED_DIM), dtype=np.float32)
+        libraries, blob = [], bytearray()
+
+        count = 0
+        for r in results:
+            path = r["path"].encode("utf-8")
+            if len(blob) + len(path) > PATH_BYTES:
+                break
+
+            if r["library"] not in libraries:
+                libraries.append(r["library"])
+
+            rec = records[count]
+            rec["score"], rec["similarity"], rec["id"] = r["score"], r["similarity"], r["id"]
+            rec["library"] = libraries.index(r["library"])
+            rec["path_offset"], rec["path_length"] = len(blob), len(path)
+            rec["offset"] = r.get("offset", 0.0)
+            blob.extend(path)
+
+            store = self.index.libraries.stores.get(r["library"])
+            if store is not None:
+                with store.pinned() as snapshot:
+                    if r["id"] < len(snapshot):
+                        vectors[count] = snapshot.embeddings[r["id"]]
+            count += 1
+
+        records = records[:count]
+        self.shm[base + SLOT_HEADER_BYTES:base + SLOT_HEADER_BYTES + records.nbytes] = records.tobytes()
+        self.shm[base + VECTORS_OFFSET:base + VECTORS_OFFSET + count * EMBED_DIM * 4] = vectors[:count].tobytes()
+        self.shm[base + PATHS_OFFSET:base + PATHS_OFFSET + len(blob)] = bytes(blob)
+        self.shm[base:base + 8] = struct.pack("<II", count, len(blob))
+        return count, libraries
@@ -0,0 +1,128 @@
+import math
+import re
+from typing import Dict, List, Tuple
+
+import numpy as np
+
+# -----------------------------
+# Config
+# -----------------------------
+
+BM25_K1 = 1.2
+BM25_B = 0.75
+RRF_K = 60
+LEXICAL_WEIGHT = 1.0
+
+# Terms in more than this share of files ("users", "samples", ...) don't
+# narrow anything down, so they never generate candidates.
+MAX_CANDIDATE_DF = 0.5
+
+TOKEN_RE = re.compile(r"[a-z0-9#]+")
+
+
+def tokenize(text: str) -> List[str]:
+    tokens = []
+    for t in TOKEN_RE.findall(text.lower()):
+        # Cheap plural folding so "Snares/" matches "snare"
+        if len(t) > 3 and t.endswith("s") and not t.endswith("ss"):
+            t = t[:-1]
+        tokens.append(t)
+    return tokens
+
+
+# -----------------------------
+# Inverted index
+# -----------------------------
+
+class LexicalIndex:
+    """
+    BM25 over path tokens, one document per vec_index. Postings are kept
+    in CSR form: term t owns doc_ids[offsets[t]:offsets[t + 1]] and the
+    matching term frequencies.
+    """
+
+    def __init__(self, texts):
+        self.n_docs = len(texts)
+        self.vocab: Dict[str, int] = {}
+        self.doc_len = np.zeros(self.n_docs, dtype=np.float32)
+
+        term_ids, doc_ids, tfs = [], [], []
+        for doc, text in enumerate(texts):
+            if not text:
+                continue
+            tokens = tokenize(text)
+            self.doc_len[doc] = len(tokens)
+
+            counts: Dict[int, int] = {}
+            for tok in tokens:
+                tid = self.vocab.setdefault(tok, len(self.vocab))
+                counts[tid] = counts.get(tid, 0) + 1
+            for tid, tf in counts.items():
+                term_ids.append(tid)
+                doc_ids.append(doc)
+                tfs.append(tf)
+
+        term_ids = np.asarray(term_ids, dtype=np.int32)
+        order = np.argsort(term_ids, kind="stable")
+        self.doc_ids = np.asarray(doc_ids, dtype=np.int32)[order]
+        self.tfs = np.asarray(tfs, dtype=np.uint16)[order]
+
+        df = np.bincount(term_ids, minlength=len(self.vocab))
+        self.offsets = np.zeros(len(self.vocab) + 1, dtype=np.int64)
+        np.cumsum(df, out=self.offsets[1:])
+
+        n_indexed = max(int(np.count_nonzero(self.doc_len)), 1)
+        self.avg_len = float(self.doc_len.sum()) / n_indexed
+        self.n_indexed = n_indexed
+
+    def search(self, text: str) -> Tuple[np.ndarray, np.ndarray]:
+        """
+        Docs containing at least one selective query term, sorted by
+        vec_index, with their BM25 scores.
+        """
+        docs, vals = [], []
+        for tok in set(tokenize(text)):
+            tid = self.vocab.get(tok)
+            if tid is None:
+                continue
+
+            start, end = self.offsets[tid], self.offsets[tid + 1]
+            df = end - start
+            if df > MAX_CANDIDATE_DF * self.n_indexed:
+                continue
+
+            d = self.doc_ids[start:end]
+            tf = self.tfs[start:end].astype(np.float32)
+            idf = math.log(1.0 + (self.n_indexed - df + 0.5) / (df + 0.5))
+            norm = BM25_K1 * (1.0 - BM25_B + BM25_B * self.doc_len[d] / self.avg_len)
+
+            docs.append(d)
+            vals.append(idf * tf * (BM25_K1 + 1.0) / (tf + norm))
+
+        if not docs:
+            return np.empty(0, dtype=np.int64), np.empty(0, dtype=np.float32)
+
+        uniq, inverse = np.unique(np.concatenate(docs), return_inverse=True)
+        scores = np.bincount(inverse, weights=np.concatenate(vals)).astype(np.float32)
+        return uniq.astype(np.int64), scores
+
+
+# -----------------------------
+# Fusion
+# -----------------------------
+
+def ranks(scores: np.ndarray) -> np.ndarray:
+    r = np.empty(len(scores), dtype=np.float32)
+    r[np.argsort(-scores, kind="stable")] = np.arange(len(scores))
+    return r
+
+
+def reciprocal_rank_fusion(sims: np.ndarray, lex: np.ndarray) -> np.ndarray:
+    """
+    Weighted RRF of the semantic and lexical rankings over one candidate
+    set. Candidates without a lexical match only get the semantic term.
+    """
+    fused = 1.0 / (RRF_K + ranks(sims) + 1.0)
+    matched = lex > 0
+    fused[matched] += LEXICAL_WEIGHT / (RRF_K + ranks(lex)[matched] + 1.0)
+    return fused
@@ -0,0 +1,217 @@
+import os
+import queue
+import threading
+from collections import deque
+from contextlib import contextmanager
+from concurrent.futures import ThreadPoolExecutor
+from typing import Callable, List, Optional, Sequence
+
+import numpy as np
+
+# -----------------------------
+# Config
+# -----------------------------
+
+# Windows per model call. CPU inference gains little past this, and the
+# writer gets work often enough to keep up.
+BATCH_SIZE = 16
+# Decoding and resampling is C code that releases the GIL; half the
+# cores leaves the rest to torch's intra-op threads.
+DECODE_WORKERS = max(1, (os.cpu_count() or 4) // 2)
+# Memory the pipeline holds has two parts, bounded separately:
+#  - decoded windows waiting for inference, at most MAX_AHEAD_WINDOWS
+#    (10 s at 48 kHz, ~1.9 MB each: ~250 MB), plus whatever windows the
+#    files that finish while the main thread is in the model bring
+#  - decodes in flight: whole files and their transients, up to the
+#    budget the caller's decode reserves from (see MemoryBudget). A file
+#    estimated over the whole budget is decoded alone, and can exceed it.
+MAX_AHEAD_WINDOWS = 128
+# Embedded batches queued for the writer before inference waits on it
+WRITE_AHEAD = 2
+
+
+# -----------------------------
+# Pipeline
+# -----------------------------
+
+class MemoryBudget:
+    """
+    Bytes shared by decode workers. reserve(n) blocks until n more fit;
+    one larger than the whole budget goes through once nothing else is
+    reserved, so an oversized file is decoded alone rather than never.
+    """
+
+    def __init__(self, limit: int):
+        self.limit = limit
+        self.used = 0
+        self.changed = threading.Condition()
+
+    @contextmanager
+    def reserve(self, n: int):
+        with self.changed:
+            self.changed.wait_for(lambda: self.used == 0 or self.used + n <= self.limit)
+            self.used += n
+        try:
+            yield
+        finally:
+            with self.changed:
+                self.used -= n
+                self.changed.notify_all()
+
+
+def run_pipeline(paths: Sequence[str],
+                 decode: Callable[[int, str], Optional[object]],
+                 embed: Callable[[List[np.ndarray]], np.ndarray],
+                 write: Callable[[list, List[np.ndarray]], None],
+                 batch_size: int = BATCH_SIZE,
+                 workers: int = DECODE_WORKERS,
+                 max_windows: int = MAX_AHEAD_WINDOWS) -> int:
+    """
+    Three overlapping stages:
+
+      decode(i, path)     on worker threads; returns an item with a
+                          `windows` list of waveforms, or None to skip
+      embed(windows)      on the calling thread, batch_size windows per
+                          call whichever files they come from; returns
+                          one vector per window
+      write(items, vecs)  on a single writer thread, once per batch, with
+                          each item's window vectors in order
+
+    Decoding runs ahead of inference until max_windows decoded windows
+    are waiting. Items reach write in path order. A batch the model rejects is retried
+    window by window, so one bad file only loses itself. Returns the number
+    of files written.
+    """
+    write_queue: "queue.Queue" = queue.Queue(maxsize=WRITE_AHEAD)
+    errors: List[BaseException] = []
+    written = [0]
+
+    def writer():
+        while True:
+            batch = write_queue.get()
+            if batch is None:
+                return
+            if errors:
+                continue  # keep draining so inference never blocks on a dead writer
+            try:
+                write(*batch)
+                written[0] += len(batch[0])
+            except BaseException as e:
+                errors.append(e)
+
+    # Windows waiting for the model, as (item, window index) in path order;
+    # items leave for the writer once all their windows are embedded
+    windows: deque = deque()
+    waiting: deque = deque()
+    # Decoded windows not yet released by flush, counted as each decode
+    # finishes; guarded by state, which decode callbacks also take
+    held = [0]
+    state = threading.RLock()
+
+    def embed_batch(batch):
+        if not batch:
+            return []
+        try:
+            return [(owner, k, v) for (owner, k), v in
+                    zip(batch, embed([owner.windows[k] for owner, k in batch]))]
+        except Exception:
+            # Find the bad file by retrying each window on its own
+            results = []
+            for owner, k in batch:
+                if owner.failed:
+                    continue
+                try:
+                    results.append((owner, k, embed([owner.windows[k]])[0]))
+                except Exception as e:
+                    owner.failed = True
+                    print(f"Error embedding {getattr(owner, 'path', owner)}: {e}")
+            return results
+
+    def flush(final: bool = False):
+        while len(windows) >= batch_size or (final and windows):
+            batch = []
+            while windows and len(batch) < batch_size:
+                owner, k = windows.popleft()
+                if not owner.failed:  # the rest of a file the model rejected
+                    batch.append((owner, k))
+            for owner, k, vector in embed_batch(batch):
+                owner.vectors[k] = vector
+                owner.remaining -= 1
+
+        items, vectors = [], []
+        while waiting and (waiting[0].remaining == 0 or waiting[0].failed):
+            item = waiting.popleft()
+            with state:
+                held[0] -= len(item.windows)
+            if not item.failed:
+                items.append(item)
+                vectors.append(np.stack(item.vectors))
+            item.windows = item.vectors = None  # the audio isn't needed past inference
+        if items:
+            write_queue.put((items, vectors))
+
+    thread = threading.Thread(target=writer, name="soundsift-index-writer", daemon=True)
+    thread.start()
+
+    try:
+        with ThreadPoolExecutor(max_workers=workers, thread_name_prefix="soundsift-decode") as pool:
+            files = iter(enumerate(paths))
+            ahead = deque()   # decodes in path order, running or done
+            decoding = [0]    # of those, still running
+            stopped = [False]
+
+            def submit():
+                # A decode per worker while the decoded audio is under
+                # budget; always one, so a single huge file can't stall
+                with state:
+                    while (not stopped[0] and decoding[0] < workers
+                           and (held[0] < max_windows or not ahead)):
+                        for i, path in files:
+                            decoding[0] += 1
+                            future = pool.submit(decode, i, path)
+                            ahead.append(future)
+                            future.add_done_callback(decoded)
+                            break
+                        else:
+                            return
+
+            def decoded(future):
+                # On the worker: count the audio, and start the next file
+                # while the main thread may be busy in the model
+                item = None if future.cancelled() or future.exception() else future.result()
+                with state:
+                    decoding[0] -= 1
+                    if item is not None:
+                        held[0] += len(item.windows)
+                submit()
+
+            try:
+                submit()
+                while True:
+                    with state:
+                        if not ahead:
+                            break
+                        future = ahead.popleft()
+                    item = future.result()
+                    if item is not None:
+                        item.vectors = [None] * len(item.windows)
+                        item.remaining = len(item.windows)
+                        item.failed = False
+                        waiting.append(item)
+                        windows.extend((item, k) for k in range(len(item.windows)))
+                        flush()
+                    if errors:
+                        break
+                    submit()
+                flush(final=True)
+            finally:
+                # Decodes finishing during shutdown mustn't queue more
+                with state:
+                    stopped[0] = True
+    finally:
+        write_queue.put(None)
+        thread.join()
+
+    if errors:
+        raise errors[0]
+    return written[0]
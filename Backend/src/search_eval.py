@@ -0,0 +1,349 @@
+"""
+Recall-versus-latency evaluation for vector search backends.
+
+Builds exact brute-force ground truth over an embeddings.bin store (or a
+synthetic one), runs every backend configuration against the same
+queries and reports recall@k, per-query latency percentiles, index
+memory (plus any per-query scratch) and build time, as a table and
+optionally as JSON.
+
+    python search_eval.py --store data --queries 500 --k 10 --json eval.json
+    python search_eval.py --synthetic 200000 --backends exact,float16,int8-r4
+"""
+import argparse
+import json
+import os
+import sys
+import time
+from typing import Callable, Dict, List, Optional
+
+import numpy as np
+
+# -----------------------------
+# Config
+# -----------------------------
+
+EMBED_DIM = 512  # matches soundsift_index.EMBED_DIM; not imported to keep the model out
+DEFAULT_K = 10
+DEFAULT_QUERIES = 200
+DEFAULT_NOISE = 0.05
+WARMUP_QUERIES = 10
+SYNTHETIC_CLUSTERS = 64
+
+
+# -----------------------------
+# Data
+# -----------------------------
+
+def normalize_rows(x: np.ndarray) -> np.ndarray:
+    return x / np.maximum(np.linalg.norm(x, axis=1, keepdims=True), 1e-12)
+
+
+def load_store(data_dir: str) -> np.ndarray:
+    path = os.path.join(data_dir, "embeddings.bin")
+    n_rows = os.path.getsize(path) // (EMBED_DIM * 4)
+    return np.memmap(path, dtype="float32", mode="r", shape=(n_rows, EMBED_DIM))
+
+
+def synthetic_store(n_rows: int, seed: int) -> np.ndarray:
+    """Clustered unit vectors, closer to real embeddings than uniform noise."""
+    rng = np.random.default_rng(seed)
+    centres = normalize_rows(rng.standard_normal((SYNTHETIC_CLUSTERS, EMBED_DIM)))
+    owners = rng.integers(0, SYNTHETIC_CLUSTERS, n_rows)
+    vectors = centres[owners] + 0.6 * rng.standard_normal((n_rows, EMBED_DIM)) / np.sqrt(EMBED_DIM)
+    return normalize_rows(vectors).astype(np.float32)
+
+
+def make_queries(vectors: np.ndarray, n: int, noise: float, seed: int) -> np.ndarray:
+    """
+    Stored vectors plus gaussian noise, renormalised: near-duplicates of
+    real rows, so the neighbourhoods they probe look like real ones.
+    """
+    rng = np.random.default_rng(seed + 1)
+    picks = rng.integers(0, len(vectors), n)
+    queries = np.asarray(vectors[picks], dtype=np.float32)
+    queries = queries + noise * rng.standard_normal(queries.shape).astype(np.float32) / np.sqrt(EMBED_DIM)
+    return normalize_rows(queries).astype(np.float32)
+
+
+def top_k(scores: np.ndarray, k: int) -> np.ndarray:
+    k = min(k, len(scores))
+    idxs = np.argpartition(-scores, k - 1)[:k]
+    return idxs[np.argsort(-scores[idxs])]
+
+
+def ground_truth(vectors: np.ndarray, queries: np.ndarray, k: int, chunk: int = 1 << 16) -> np.ndarray:
+    """Exact top-k ids per query, scanning the store in chunks to bound memory."""
+    n_q = len(queries)
+    best_ids = np.full((n_q, 0), -1, dtype=np.int64)
+    best_scores = np.full((n_q, 0), -np.inf, dtype=np.float32)
+
+    for start in range(0, len(vectors), chunk):
+        block = np.asarray(vectors[start:start + chunk], dtype=np.float32)
+        scores = np.concatenate([best_scores, queries @ block.T], axis=1)
+        ids = np.concatenate([best_ids, np.broadcast_to(np.arange(start, start + len(block)), (n_q, len(block)))], axis=1)
+        keep = np.argsort(-scores, axis=1, kind="stable")[:, :k]
+        best_scores = np.take_along_axis(scores, keep, axis=1)
+        best_ids = np.take_along_axis(ids, keep, axis=1)
+    return best_ids
+
+
+# -----------------------------
+# Backends
+# -----------------------------
+
+class Backend:
+    """
+    A search configuration under test: build() prepares whatever index it
+    needs from the store and returns its size in bytes; search() returns
+    the ids of the k best rows for one normalised query. scratch_bytes is
+    the temporary memory one search allocates on top of the index.
+    """
+
+    name = "backend"
+    scratch_bytes = 0
+
+    def build(self, vectors: np.ndarray) -> int:
+        raise NotImplementedError
+
+    def ground_truth(self, queries: np.ndarray, k: int) -> Optional[np.ndarray]:
+        """
+        Exact top-k ids under this backend's own scoring, for one that
+        doesn't rank by plain similarity to embeddings.bin rows; None to
+        be measured against the shared ground truth. Called after build.
+        """
+        return None
+
+    def search(self, query: np.ndarray, k: int) -> np.ndarray:
+        raise NotImplementedError
+
+
+class ExactBackend(Backend):
+    """Full scan over the mapped float32 vectors, as LibraryStore does."""
+
+    name = "exact"
+
+    def build(self, vectors):
+        self.vectors = vectors
+        return 0  # scans the store's own mapping
+
+    def search(self, query, k):
+        return top_k(self.vectors @ query, k)
+
+
+class Float16Backend(Backend):
+    """Full scan over a half-precision copy: half the memory and bandwidth."""
+
+    name = "float16"
+
+    def build(self, vectors):
+        self.vectors = np.asarray(vectors, dtype=np.float16)
+        return self.vectors.nbytes
+
+    def search(self, query, k):
+        return top_k((self.vectors @ query.astype(np.float16)).astype(np.float32), k)
+
+
+class Int8Backend(Backend):
+    """
+    Per-dimension scalar quantisation to int8. With rerank > 1, the best
+    k * rerank candidates are rescored exactly against the float32 store.
+
+    The recall is the int8 codes' own, but the scan is not an integer
+    kernel: numpy has no int8 product accumulating in int32, so each
+    SCAN_CHUNK rows are widened to float32 and multiplied as floats. The
+    latency is that widening plus a float scan, an upper bound on what an
+    int8 dot-product kernel would take; the widened chunk is reported as
+    scratch memory.
+    """
+
+    SCAN_CHUNK = 1 << 14
+
+    def __init__(self, rerank: int = 1):
+        self.rerank = rerank
+        self.name = "int8" if rerank <= 1 else f"int8-r{rerank}"
+
+    def build(self, vectors):
+        self.vectors = vectors
+        data = np.asarray(vectors, dtype=np.float32)
+        self.scale = np.maximum(np.abs(data).max(axis=0), 1e-12) / 127.0
+        self.codes = np.round(data / self.scale).astype(np.int8)
+        chunk = min(self.SCAN_CHUNK, len(self.codes))
+        self.widened = np.empty((chunk, self.codes.shape[1]), dtype=np.float32)
+        self.scratch_bytes = self.widened.nbytes + len(self.codes) * 4  # + the scores
+        return self.codes.nbytes + self.scale.nbytes
+
+    def search(self, query, k):
+        # Folding the scale into the query keeps the scan a single product
+        scaled = (query * self.scale).astype(np.float32)
+        approx = np.empty(len(self.codes), dtype=np.float32)
+        for start in range(0, len(self.codes), self.SCAN_CHUNK):
+            codes = self.codes[start:start + self.SCAN_CHUNK]
+            widened = self.widened[:len(codes)]
+            widened[:] = codes
+            np.matmul(widened, scaled, out=approx[start:start + len(codes)])
+        if self.rerank <= 1:
+            return top_k(approx, k)
+        cand = top_k(approx, k * self.rerank)
+        exact = np.asarray(self.vectors[np.sort(cand)], dtype=np.float32) @ query
+        return np.sort(cand)[top_k(exact, k)]
+
+
+class StoreBackend(Backend):
+    """
+    The production path: LibraryStore.search in semantic mode over a real
+    store directory, catalog and filters included. Needs soundsift.db.
+
+    Long files score as their best segment window there, so recall is
+    against an exact scan of those pooled scores: it checks the path
+    returns the true top k, and the row is otherwise about latency.
+    """
+
+    name = "store"
+
+    def __init__(self, data_dir: str):
+        self.data_dir = data_dir
+
+    def build(self, vectors):
+        from soundsift_index import LibraryStore
+
+        self.store = LibraryStore("eval", None, self.data_dir)
+        self.store.attach()
+        self.store.warm()
+        return 0
+
+    def search(self, query, k):
+        return np.array([hit[2] for hit in self.store.search(query, k, mode="semantic")], dtype=np.int64)
+
+    def ground_truth(self, queries, k):
+        truth = []
+        with self.store.pinned() as snapshot:
+            n_rows = len(snapshot.embeddings)
+            for q in queries:
+                scores = np.asarray(snapshot.embeddings @ q, dtype=np.float32)
+                if len(snapshot.segments):
+                    scores = np.maximum(scores, snapshot.segments.best_per_file(q, n_rows)[0])
+                truth.append(top_k(scores, k))
+        return np.array(truth, dtype=np.int64)
+
+
+def make_backends(names: List[str], data_dir: Optional[str]) -> List[Backend]:
+    factories: Dict[str, Callable[[], Backend]] = {
+        "exact": ExactBackend,
+        "float16": Float16Backend,
+        "int8": lambda: Int8Backend(1),
+        "int8-r2": lambda: Int8Backend(2),
+        "int8-r4": lambda: Int8Backend(4),
+    }
+    if data_dir is not None and os.path.exists(os.path.join(data_dir, "soundsift.db")):
+        factories["store"] = lambda: StoreBackend(data_dir)
+
+    backends = []
+    for name in names:
+        if name not in factories:
+            print(f"Skipping unknown or unavailable backend {name!r}", file=sys.stderr)
+            continue
+        backends.append(factories[name]())
+    return backends
+
+
+# -----------------------------
+# Evaluation
+# -----------------------------
+
+def evaluate(backend: Backend, vectors: np.ndarray, queries: np.ndarray,
+             truth: np.ndarray, k: int) -> Dict[str, float]:
+    t0 = time.perf_counter()
+    index_bytes = backend.build(vectors)
+    build_s = time.perf_counter() - t0
+
+    own_truth = backend.ground_truth(queries, k)
+    if own_truth is not None:
+        truth = own_truth
+
+    for q in queries[:WARMUP_QUERIES]:
+        backend.search(q, k)
+
+    latencies = np.empty(len(queries))
+    recalls = np.empty(len(queries))
+    for i, q in enumerate(queries):
+        t0 = time.perf_counter()
+        ids = backend.search(q, k)
+        latencies[i] = (time.perf_counter() - t0) * 1000.0
+        recalls[i] = len(np.intersect1d(ids[:k], truth[i])) / min(k, truth.shape[1])
+
+    p50, p95, p99 = np.percentile(latencies, [50, 95, 99])
+    return {
+        "backend": backend.name,
+        "recall_at_k": float(recalls.mean()),
+        "min_recall": float(recalls.min()),
+        "p50_ms": float(p50),
+        "p95_ms": float(p95),
+        "p99_ms": float(p99),
+        "max_ms": float(latencies.max()),
+        "qps": float(1000.0 / latencies.mean()),
+        "index_bytes": int(index_bytes),
+        "scratch_bytes": int(backend.scratch_bytes),
+        "build_s": float(build_s),
+    }
+
+
+def print_table(rows: List[Dict[str, float]], k: int):
+    header = f"{'backend':<10} {'recall@' + str(k):>9} {'min':>6} {'p50 ms':>8} {'p95 ms':>8} {'p99 ms':>8} {'qps':>9} {'index MB':>9} {'scratch MB':>10} {'build s':>8}"
+    print(header)
+    print("-" * len(header))
+    for r in rows:
+        print(f"{r['backend']:<10} {r['recall_at_k']:>9.4f} {r['min_recall']:>6.2f} {r['p50_ms']:>8.3f} "
+              f"{r['p95_ms']:>8.3f} {r['p99_ms']:>8.3f} {r['qps']:>9.1f} "
+              f"{r['index_bytes'] / 1e6:>9.1f} {r['scratch_bytes'] / 1e6:>10.1f} {r['build_s']:>8.3f}")
+
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    source = parser.add_mutually_exclusive_group()
+    source.add_argument("--store", default="data", help="store directory holding embeddings.bin")
+    source.add_argument("--synthetic", type=int, metavar="ROWS", help="evaluate on a generated store instead")
+    parser.add_argument("--backends", default="exact,store,float16,int8,int8-r4")
+    parser.add_argument("--k", type=int, default=DEFAULT_K)
+    parser.add_argument("--queries", type=int, default=DEFAULT_QUERIES)
+    parser.add_argument("--noise", type=float, default=DEFAULT_NOISE, help="query perturbation, relative to a unit vector")
+    parser.add_argument("--seed", type=int, default=0)
+    parser.add_argument("--json", metavar="PATH", help="also write the results here")
+    args = parser.parse_args(argv)
+
+    if args.synthetic:
+        vectors, data_dir = synthetic_store(args.synthetic, args.seed), None
+    else:
+        vectors, data_dir = load_store(args.store), args.store
+    if len(vectors) == 0:
+        parser.error("store is empty")
+
+    queries = make_queries(vectors, args.queries, args.noise, args.seed)
+
+    t0 = time.perf_counter()
+    truth = ground_truth(vectors, queries, args.k)
+    truth_s = time.perf_counter() - t0
+
+    print(f"{len(vectors)} rows x {EMBED_DIM}, {len(queries)} queries, k={args.k}, "
+          f"ground truth in {truth_s:.2f} s")
+
+    rows = [evaluate(b, vectors, queries, truth, args.k)
+            for b in make_backends(args.backends.split(","), data_dir)]
+    print_table(rows, args.k)
+
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump({
+                "rows": len(vectors),
+                "dim": EMBED_DIM,
+                "queries": len(queries),
+                "k": args.k,
+                "noise": args.noise,
+                "source": "synthetic" if args.synthetic else os.path.abspath(args.store),
+                "ground_truth_s": truth_s,
+                "results": rows,
+            }, f, indent=2)
+
+
+if __name__ == "__main__":
+    main()
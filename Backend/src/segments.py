@@ -0,0 +1,124 @@
+import os
+import struct
+from typing import Optional, Tuple
+
+import numpy as np
+
+# -----------------------------
+# Config
+# -----------------------------
+
+SEGMENT_VERSION = 1
+HEADER_BYTES = 16
+
+# Window 0 is the file's own embedding in embeddings.bin, so a file only
+# gets segments here when it runs past the first window
+SEGMENT_SECONDS = 10.0
+SEGMENT_HOP_SECONDS = 5.0
+MAX_SEGMENTS_PER_FILE = 64
+
+RECORD_DTYPE = np.dtype([
+    ("vec_index", "<i4"),
+    ("offset", "<f4"),    # window start, seconds into the file
+])
+
+
+def segment_offsets(duration: float) -> np.ndarray:
+    """
+    Start times of the windows after the first, the last one flush with the
+    end. Past MAX_SEGMENTS_PER_FILE windows the hop widens instead, so the
+    cap thins out coverage of a long file rather than cutting off its end.
+    """
+    if duration <= SEGMENT_SECONDS:
+        return np.empty(0, dtype=np.float32)
+    last = duration - SEGMENT_SECONDS
+    offsets = np.append(np.arange(SEGMENT_HOP_SECONDS, last, SEGMENT_HOP_SECONDS), last)
+    if len(offsets) > MAX_SEGMENTS_PER_FILE:
+        offsets = np.linspace(SEGMENT_HOP_SECONDS, last, MAX_SEGMENTS_PER_FILE)
+    return offsets.astype(np.float32)
+
+
+def segment_windows(audio: np.ndarray, sr: int) -> Tuple[np.ndarray, np.ndarray]:
+    """(offsets, windows[n, SEGMENT_SECONDS * sr]) for one mono signal."""
+    offsets = segment_offsets(len(audio) / sr)
+    length = int(SEGMENT_SECONDS * sr)
+    windows = np.zeros((len(offsets), length), dtype=np.float32)
+    for i, offset in enumerate(offsets):
+        start = int(round(offset * sr))
+        chunk = audio[start:start + length]
+        windows[i, :len(chunk)] = chunk
+    return offsets, windows
+
+
+# -----------------------------
+# Sidecar
+# -----------------------------
+
+def write_segments(out_path: str, records: np.ndarray, vectors: np.ndarray):
+    """
+    segments.bin: "SSSG", uint32 version, uint32 count, uint32 dim, then
+    count RECORD_DTYPE records, then count normalised float32 vectors.
+    Records are grouped by vec_index in indexing order.
+    """
+    temp_path = out_path + ".tmp"
+    with open(temp_path, "wb") as f:
+        f.write(b"SSSG")
+        f.write(struct.pack("<III", SEGMENT_VERSION, len(records), vectors.shape[1]))
+        f.write(np.ascontiguousarray(records, dtype=RECORD_DTYPE).tobytes())
+        f.write(np.ascontiguousarray(vectors, dtype="<f4").tobytes())
+    os.replace(temp_path, out_path)
+
+
+class SegmentTable:
+    """Memory-mapped view of segments.bin; empty when the file is missing."""
+
+    def __init__(self, path: str, dim: int):
+        self.records = np.empty(0, dtype=RECORD_DTYPE)
+        self.vectors = np.empty((0, dim), dtype=np.float32)
+
+        if not os.path.exists(path) or os.path.getsize(path) < HEADER_BYTES:
+            return
+        with open(path, "rb") as f:
+            magic, version, count, file_dim = struct.unpack("<4sIII", f.read(HEADER_BYTES))
+        expected = HEADER_BYTES + count * (RECORD_DTYPE.itemsize + file_dim * 4)
+        if (magic != b"SSSG" or version != SEGMENT_VERSION or file_dim != dim
+                or count == 0 or os.path.getsize(path) < expected):
+            return
+
+        self.records = np.memmap(path, dtype=RECORD_DTYPE, mode="r",
+                                 offset=HEADER_BYTES, shape=(count,))
+        self.vectors = np.memmap(path, dtype="<f4", mode="r",
+                                 offset=HEADER_BYTES + count * RECORD_DTYPE.itemsize,
+                                 shape=(count, dim))
+
+    def __len__(self):
+        return len(self.records)
+
+    def best_per_file(self, q_emb: np.ndarray, n_rows: int,
+                      rows: Optional[np.ndarray] = None) -> Tuple[np.ndarray, np.ndarray]:
+        """
+        Max-pooled segment similarity per vec_index and the offset of the
+        winning window; -inf and 0 for files without segments (or outside
+        rows, when given).
+        """
+        best = np.full(n_rows, -np.inf, dtype=np.float32)
+        offset = np.zeros(n_rows, dtype=np.float32)
+        if len(self.records) == 0:
+            return best, offset
+
+        owners = self.records["vec_index"]
+        keep = owners < n_rows
+        if rows is not None:
+            keep &= np.isin(owners, rows)
+        idx = np.flatnonzero(keep)
+        if len(idx) == 0:
+            return best, offset
+
+        vectors = self.vectors if len(idx) == len(owners) else self.vectors[idx]
+        sims = vectors @ (q_emb / np.linalg.norm(q_emb))
+        # Best window first, then the first occurrence of each file is its max
+        order = np.argsort(-sims, kind="stable")
+        files, first = np.unique(owners[idx][order], return_index=True)
+        best[files] = sims[order][first]
+        offset[files] = self.records["offset"][idx][order][first]
+        return best, offset
@@ -1,21 +1,41 @@
 import os
+import json
+import time
+import heapq
+import struct
+import threading
+import zlib
+from contextlib import contextmanager
 import numpy as np
 import librosa
+import torch
 import laion_clap
-from typing import List
+from concurrent.futures import ThreadPoolExecutor
+from typing import Dict, List, Optional
 import re
 
 from db import (
     init_db,
+    get_catalog,
     get_sample_by_path,
     upsert_sample,
     insert_sample,
+    insert_samples,
+    delete_samples_from,
+    get_indexed_paths,
     store_embedding,
     store_text_embedding,
     blob_to_np,
     get_connection,
     get_sample_by_index
 )
+from descriptors import COLUMNS as DESCRIPTOR_COLUMNS, DescriptorTable, analyse, write_descriptors
+from filters import Catalog, FilterError, QueryFilters
+from lexical import LexicalIndex, reciprocal_rank_fusion
+from pipeline import MemoryBudget, run_pipeline
+from segments import RECORD_DTYPE as SEGMENT_DTYPE, SegmentTable, segment_windows, write_segments
+from suggest import count_terms, write_suggest_trie
+from tags import NAMES as TAG_NAMES, PROMPTS as TAG_PROMPTS, TagTable, score_rows, write_tags
 
 # -----------------------------
 # Config
@@ -25,7 +45,22 @@ SAMPLE_RATE = 48000
 SUPPORTED_EXTS = {".wav", ".aif", ".aiff", ".flac", ".mp3"}
 MODEL_VERSION = "default"
 EMBED_DIM = 512
-EMBEDDINGS_PATH = "data/embeddings.bin"
+DATA_DIR = "data"
+EMBEDDINGS_PATH = os.path.join(DATA_DIR, "embeddings.bin")
+LIBRARIES_PATH = os.path.join(DATA_DIR, "libraries.json")
+SUGGEST_PATH = os.path.join(DATA_DIR, "suggest.bin")
+# Written by export_text_encoder.py; the plugin encodes queries with it in process
+TEXT_ENCODER_DIR = os.path.join(DATA_DIR, "text_encoder")
+DEFAULT_LIBRARY = "default"
+
+# Decodes in flight across all workers, by decode_bytes' estimate: a few
+# one-minute files at a time, or one long stem and small files beside it
+DECODE_BUDGET_BYTES = 1 << 30
+DECODE_COPIES = 5  # stereo read (2), mono mix, resample, segment windows
+
+# Registered libraries keep their store on the drive they index, so
+# unmounting the drive takes its shard with it.
+LIBRARY_STORE_DIR = ".soundsift"
 
 
 # -----------------------------
@@ -41,13 +76,27 @@ def find_audio_files(root: str) -> List[str]:
     return files
 
 
-def load_audio_mono(path: str, max_seconds: float) -> np.ndarray:
+def decode_bytes(path: str) -> int:
+    """
+    Rough peak memory of decoding one file for indexing: the native-rate
+    multichannel read, the mono mix, the resample and the segment windows
+    are each about the file's length at SAMPLE_RATE in float32.
+    """
+    try:
+        seconds = librosa.get_duration(path=path)
+    except Exception:
+        return DECODE_BUDGET_BYTES  # unknown length: decode it alone
+    return int(seconds * SAMPLE_RATE * 4 * DECODE_COPIES)
+
+
+def load_audio_mono(path: str, max_seconds: Optional[float]) -> np.ndarray:
     audio, _ = librosa.load(path, sr=SAMPLE_RATE, mono=True)
+    if max_seconds is None:
+        return audio
     return audio[: int(SAMPLE_RATE * max_seconds)]
 
 
 def cosine_similarity_matrix(query: np.ndarray, vectors: np.ndarray):
-    print(vectors)
     query = query / np.linalg.norm(query)
     # vectors = vectors / np.linalg.norm(vectors, axis=1, keepdims=True)
     return vectors @ query
@@ -63,53 +112,256 @@ def path_to_text(path: str) -> str:
 
     return " ".join(tokens)
 
+def write_path_table(out_path: str, rows, n_rows: int):
+    """
+    paths.bin sidecar mapping vec_index -> path, read natively by the
+    plugin (PathTable.h): "SSPT", uint32 count, uint64 offsets[count + 1],
+    then the UTF-8 paths back to back.
+    """
+    paths = [b""] * n_rows
+    for vec_index, path, *_ in rows:
+        if 0 <= vec_index < n_rows and path:
+            paths[vec_index] = path.encode("utf-8")
+
+    offsets = np.zeros(n_rows + 1, dtype="<u8")
+    np.cumsum([len(p) for p in paths], out=offsets[1:])
+
+    temp_path = out_path + ".tmp"
+    with open(temp_path, "wb") as f:
+        f.write(b"SSPT")
+        f.write(struct.pack("<I", n_rows))
+        f.write(offsets.tobytes())
+        f.write(b"".join(paths))
+    os.replace(temp_path, out_path)
+
 def normalize_vector(v):
     norm = np.linalg.norm(v)
     if norm == 0: 
         return v
     return v / norm
 
+class DecodedFile:
+    """One file on its way through the indexing pipeline."""
 
+    def __init__(self, path: str, vec_index: int, mtime: float, duration: float):
+        self.path = path
+        self.vec_index = vec_index
+        self.mtime = mtime
+        self.duration = duration
+        self.descriptors: List[float] = []
+        self.windows: Optional[List[np.ndarray]] = None
+        self.offsets = np.empty(0, dtype=np.float32)
 
-# -----------------------------
-# Main Index Class
-# -----------------------------
 
-class SoundSiftIndex:
-    def __init__(self):
-        init_db()
 
-        self.model = laion_clap.CLAP_Module(enable_fusion=False)
-        self.model.load_ckpt()
+# -----------------------------
+# Library Stores
+# -----------------------------
 
-        self.paths: List[str] = []
+class StoreSnapshot:
+    """
+    One committed version of a store: the vector mapping, window vectors,
+    catalog and lexical index, all read from the same files and never
+    changed afterwards. Queries pin a snapshot for their whole run
+    (LibraryStore.pinned), so indexing can commit underneath them; a
+    retired snapshot drops its mappings when the last reader lets go.
+    """
+
+    def __init__(self, store: "LibraryStore", generation: int):
+        self.generation = generation
+        self.refs = 0
+        self.retired = False
         self.embeddings = None
-        self.loaded = False
-        
+        self.segments = None
+        self.catalog = None
+        self.lexical = None
+        self.lexical_lock = threading.Lock()
 
-    def load(self):
-        if not os.path.exists(EMBEDDINGS_PATH):
-            self.embeddings = None
+        if not os.path.exists(store.embeddings_path):
             return
 
-        file_size = os.path.getsize(EMBEDDINGS_PATH)
-        n_rows = file_size // (EMBED_DIM * 4) # 4 bytes per float32
-        # print(n_rows)
-        
+        n_rows = os.path.getsize(store.embeddings_path) // (EMBED_DIM * 4) # 4 bytes per float32
         if n_rows == 0:
-            self.embeddings = None
             return
 
         self.embeddings = np.memmap(
-            EMBEDDINGS_PATH, 
+            store.embeddings_path, 
             dtype='float32', 
             mode='r', 
             shape=(n_rows, EMBED_DIM)
         )
+        self.segments = SegmentTable(store.segments_path, EMBED_DIM)
+
+        # Stores indexed before paths.bin existed get one on first load
+        if not os.path.exists(store.paths_path):
+            write_path_table(store.paths_path, get_catalog(store.db_path), n_rows)
+
+        # Rows the indexer has added to the DB since this version's vectors
+        # were written are beyond n_rows and left out
+        self.catalog = Catalog(n_rows, store.db_path, store.descriptors_path, store.tags_path)
+
+    def __len__(self):
+        return 0 if self.embeddings is None else len(self.embeddings)
+
+    def lexical_index(self) -> LexicalIndex:
+        """Built by the first hybrid query; paths don't change within a version."""
+        with self.lexical_lock:
+            if self.lexical is None:
+                self.lexical = LexicalIndex([
+                    path_to_text(p) if p else None for p in self.catalog.paths
+                ])
+            return self.lexical
+
+    def descriptors(self, vec_index: int) -> Optional[Dict[str, float]]:
+        return None if self.catalog is None else self.catalog.descriptors.row(vec_index)
+
+    def tag_counts(self, filters: Optional[QueryFilters] = None) -> np.ndarray:
+        if self.catalog is None:
+            return np.zeros(len(TAG_NAMES), dtype=np.int64)
+        return self.catalog.tag_counts(self.catalog.compile(filters))
+
+    def top_tagged(self, tag: str, top_k: int, filters: Optional[QueryFilters] = None):
+        """(score, vec_index, path, descriptors) of the rows scoring highest for tag."""
+        if self.catalog is None or tag not in TAG_NAMES:
+            return []
+        bitmap = self.catalog.compile(filters)
+        rows = self.catalog.rows(self.catalog.valid() if bitmap is None else bitmap)
+        idxs, scores = self.catalog.tags.top(tag, top_k, rows)
+        return [(float(score), int(i), self.catalog.paths[i], self.descriptors(int(i)))
+                for i, score in zip(idxs, scores) if np.isfinite(score)]
+
+    def close(self):
+        self.embeddings = None
+        self.segments = None
+        self.catalog = None
+        self.lexical = None
+
+
+class LibraryStore:
+    """
+    One shard: an embeddings.bin vector store plus its own samples
+    catalog. vec_index values are local to the store.
+    """
+
+    def __init__(self, name: str, root: Optional[str], data_dir: str):
+        self.name = name
+        self.root = root
+        self.data_dir = data_dir
+        self.embeddings_path = os.path.join(data_dir, "embeddings.bin")
+        self.db_path = os.path.join(data_dir, "soundsift.db")
+        self.paths_path = os.path.join(data_dir, "paths.bin")
+        self.descriptors_path = os.path.join(data_dir, "descriptors.bin")
+        self.segments_path = os.path.join(data_dir, "segments.bin")
+        self.tags_path = os.path.join(data_dir, "tags.bin")
+
+        self.snapshot: Optional[StoreSnapshot] = None
+        self.generation = 0
+        self.snapshot_lock = threading.Lock()
+        self.attached = False
+
+    def is_mounted(self) -> bool:
+        return self.root is None or os.path.isdir(self.root)
+
+    def contains(self, folder: str) -> bool:
+        if self.root is None:
+            return False
+        root = os.path.join(os.path.normpath(self.root), "")
+        return os.path.join(os.path.normpath(folder), "").startswith(root)
+
+    def attach(self):
+        if not self.attached:
+            init_db(self.db_path)
+            self.attached = True
+
+    def detach(self):
+        self.publish(None)
+        self.attached = False
+
+    # ---------- SNAPSHOTS ----------
+
+    @contextmanager
+    def pinned(self):
+        """
+        The current version, mapped on first use and then shared by every
+        reader until index_folder publishes the next one.
+        """
+        with self.snapshot_lock:
+            if self.snapshot is None:
+                self.generation += 1
+                self.snapshot = StoreSnapshot(self, self.generation)
+            snapshot = self.snapshot
+            snapshot.refs += 1
+        try:
+            yield snapshot
+        finally:
+            with self.snapshot_lock:
+                snapshot.refs -= 1
+                if snapshot.retired and snapshot.refs == 0:
+                    snapshot.close()
+
+    def publish(self, snapshot: Optional[StoreSnapshot]):
+        """Make snapshot current (None: map lazily on next pin) and retire the old one."""
+        with self.snapshot_lock:
+            old, self.snapshot = self.snapshot, snapshot
+            if old is not None:
+                old.retired = True
+                if old.refs == 0:
+                    old.close()
+
+    def commit(self):
+        """Map the files index_folder just wrote as the next version."""
+        with self.snapshot_lock:
+            self.generation += 1
+            generation = self.generation
+        # Built outside the lock so readers keep pinning the old version meanwhile
+        self.publish(StoreSnapshot(self, generation))
+
+    def warm(self) -> int:
+        """
+        Map the store, fault the vectors and path table into the page
+        cache and build the catalog and lexical index, so the first query
+        doesn't pay for any of it. Returns the row count.
+        """
+        with self.pinned() as snapshot:
+            if len(snapshot) == 0:
+                return 0
+
+            # Reading through the mapping in large chunks is what faults it in
+            chunk = 1 << 14
+            for start in range(0, len(snapshot.embeddings), chunk):
+                np.asarray(snapshot.embeddings[start:start + chunk]).sum()
+            for start in range(0, len(snapshot.segments), chunk):
+                np.asarray(snapshot.segments.vectors[start:start + chunk]).sum()
+
+            if os.path.exists(self.paths_path):
+                with open(self.paths_path, "rb") as f:
+                    while f.read(1 << 20):
+                        pass
+
+            snapshot.lexical_index()
+            return len(snapshot)
+
+    def refresh_tags(self, tag_vectors) -> bool:
+        """
+        Rescores every row when tags.bin is missing, short or written for
+        another vocabulary (stores indexed before it existed, or after the
+        prompts changed). tag_vectors is only called if there's work.
+        """
+        with self.pinned() as snapshot:
+            if len(snapshot) == 0 or len(snapshot.catalog.tags) >= len(snapshot):
+                return False
+            write_tags(self.tags_path, score_rows(snapshot.embeddings, tag_vectors()))
+        self.commit()
+        return True
 
     # ---------- INDEXING ----------
     
-    def index_folder(self, folder: str):
+    def index_folder(self, folder: str, model, tag_vectors: np.ndarray, segments: bool = True):
+        """
+        Embeds files not yet in the store. With segments, files longer than
+        one window also get overlapping window embeddings in segments.bin.
+        New rows are scored against tag_vectors into tags.bin.
+        """
         dtype = np.float32
         itemsize = 4 * EMBED_DIM
 
@@ -117,8 +369,9 @@ class SoundSiftIndex:
         new_files = []
         
         # This check is important. Only add files we haven't indexed yet.
+        indexed = get_indexed_paths(self.db_path)
         for f in all_files:
-            if not get_sample_by_path(f): # Check DB
+            if f not in indexed:
                 new_files.append(f)
         
         N_new = len(new_files)
@@ -127,12 +380,12 @@ class SoundSiftIndex:
             return
 
         N_old = 0
-        if os.path.exists(EMBEDDINGS_PATH):
-            file_size = os.path.getsize(EMBEDDINGS_PATH)
-        N_old = file_size // itemsize
+        if os.path.exists(self.embeddings_path):
+            file_size = os.path.getsize(self.embeddings_path)
+            N_old = file_size // itemsize
         N_total = N_old + N_new
 
-        temp_emb_path = EMBEDDINGS_PATH + ".tmp"
+        temp_emb_path = self.embeddings_path + ".tmp"
         with open(temp_emb_path, "wb") as file:
             file.truncate(N_total * itemsize)
 
@@ -148,7 +401,7 @@ class SoundSiftIndex:
             # We assume the old file is valid. 
             # We map it read-only to copy quickly.
             old_mmap = np.memmap(
-                EMBEDDINGS_PATH, 
+                self.embeddings_path, 
                 dtype=dtype, 
                 mode='r', 
                 shape=(N_old, EMBED_DIM)
@@ -161,42 +414,372 @@ class SoundSiftIndex:
             del old_mmap
         
         start_idx = N_old
+        descriptors = DescriptorTable(self.descriptors_path, N_old).grown(N_total)
+        tag_scores, n_scored = TagTable(self.tags_path, N_old).grown(N_total)
+        segment_records, segment_vectors = [], []
 
-        for i, path in enumerate(new_files):
-            try:
-                # Load & Embed
-                audio = load_audio_mono(path, 10.0) # Reduced to 10s for speed
-                if len(audio) == 0: continue 
-
-                audio = audio.reshape(1, -1)
-                emb = self.model.get_audio_embedding_from_data(x=audio, use_tensor=False)[0]
-                
-                # Write to Binary (Normalized)
-                cur_idx = start_idx + i
-                new_emb_mmap[cur_idx] = normalize_vector(emb).astype(dtype)
-
-                # Update DB
-                # Note: get stat info again or cache it from step 1
-                stat = os.stat(path)
-                duration = len(audio[0]) / SAMPLE_RATE
-                insert_sample(path, cur_idx, stat.st_mtime, duration)
-                
-                # Also index text metadata
-                # self.index_text(upsert_sample(path, stat.st_mtime, duration), path)
+        budget = MemoryBudget(DECODE_BUDGET_BYTES)
 
+        def decode(i: int, path: str):
+            # Decode workers: everything per file that doesn't need the model.
+            # Long files take more of the budget, so fewer decode at once.
+            try:
+                with budget.reserve(decode_bytes(path)):
+                    full_audio = load_audio_mono(path, None)
+                    if len(full_audio) == 0:
+                        return None
+                    stat = os.stat(path)
+                    item = DecodedFile(path, start_idx + i, stat.st_mtime, len(full_audio) / SAMPLE_RATE)
+                    # Descriptors see the whole file, not just the embedded part;
+                    # taken by name, so the row follows descriptors.COLUMNS
+                    values = analyse(full_audio, SAMPLE_RATE)
+                    item.descriptors = [values[name] for name in DESCRIPTOR_COLUMNS]
+                    item.windows = [full_audio[: int(SAMPLE_RATE * 10.0)].copy()]  # Reduced to 10s for speed
+                    # Later windows of long files
+                    if segments:
+                        item.offsets, windows = segment_windows(full_audio, SAMPLE_RATE)
+                        item.windows.extend(windows)
+                return item
             except Exception as e:
                 print(f"Error indexing {path}: {e}")
+                return None
+
+        def embed(windows: List[np.ndarray]) -> np.ndarray:
+            # A list rather than one (B, N) array: the model repeat-pads
+            # each clip on its own, so short files embed as they would alone
+            with torch.inference_mode():
+                return model.get_audio_embedding_from_data(x=windows, use_tensor=False)
+
+        def write(items: List[DecodedFile], vectors: List[np.ndarray]):
+            # Writer thread: the only one touching the mmap, sidecar arrays and DB
+            rows = []
+            for item, embs in zip(items, vectors):
+                embs = embs / np.maximum(np.linalg.norm(embs, axis=1, keepdims=True), 1e-12)
+                new_emb_mmap[item.vec_index] = embs[0].astype(dtype)
+                for col, value in enumerate(item.descriptors):
+                    descriptors[col, item.vec_index] = value
+                if len(item.offsets):
+                    records = np.zeros(len(item.offsets), dtype=SEGMENT_DTYPE)
+                    records["vec_index"], records["offset"] = item.vec_index, item.offsets
+                    segment_records.append(records)
+                    segment_vectors.append(embs[1:].astype(dtype))
+                rows.append((item.path, item.vec_index, item.mtime, item.duration))
+            # Vectors without catalog rows would be re-indexed next run
+            # under new vec_index values; stop the run instead
+            if not insert_samples(rows, self.db_path):
+                raise RuntimeError(f"could not catalog {len(rows)} indexed files in {self.db_path}")
+
+        start = time.time()
+        try:
+            n_indexed = run_pipeline(new_files, decode, embed, write)
+        except BaseException:
+            # Nothing is published: forget the rows already cataloged so
+            # the next run indexes those files again
+            del new_emb_mmap
+            os.remove(temp_emb_path)
+            delete_samples_from(start_idx, self.db_path)
+            raise
+        elapsed = time.time() - start
+        print(f"Indexed {n_indexed}/{N_new} files in {elapsed:.1f} s ({n_indexed / max(elapsed, 1e-9):.1f} files/s)")
+
+        # Only rows the old tags.bin didn't cover; all of them if it was stale
+        tag_scores[n_scored:] = score_rows(new_emb_mmap[n_scored:], tag_vectors)
 
         new_emb_mmap.flush()
         del new_emb_mmap # Close the file handle
         
-        # Atomic Swap: Replace old file with new file
-        if os.path.exists(EMBEDDINGS_PATH):
-            os.remove(EMBEDDINGS_PATH)
-        os.rename(temp_emb_path, EMBEDDINGS_PATH)
-
+        # Sidecars first: rows past a reader's embeddings.bin are ignored, so
+        # a snapshot mapped at any point in here is still self-consistent
+        write_path_table(self.paths_path, get_catalog(self.db_path), N_total)
+        write_descriptors(self.descriptors_path, descriptors)
+        write_tags(self.tags_path, tag_scores)
+
+        if segment_records:
+            old = SegmentTable(self.segments_path, EMBED_DIM)
+            records = np.concatenate([np.asarray(old.records)] + segment_records)
+            vectors = np.concatenate([np.asarray(old.vectors)] + segment_vectors)
+            del old
+            write_segments(self.segments_path, records, vectors)
+
+        # Atomic Swap: readers holding the old mapping keep the old inode
+        os.replace(temp_emb_path, self.embeddings_path)
+
+        self.commit()
         return new_files
 
+    # ---------- QUERY ----------
+
+    def search(self, q_emb: np.ndarray, top_k: int,
+               filters: Optional[QueryFilters] = None,
+               text: Optional[str] = None, mode: str = "hybrid"):
+        """
+        Per-shard candidates as (similarity, lexical, vec_index, path,
+        offset, descriptors), by similarity, all read from one pinned
+        snapshot. lexical is the BM25 score over path tokens (0 without a
+        match, always 0 in "semantic" mode). Scores are left unfused:
+        ranks only mean something over every shard's candidates, so
+        query() fuses after the merge. offset is where the best matching
+        window starts, in seconds (0 unless a segment beat the file's
+        first window).
+        """
+        with self.pinned() as snapshot:
+            return self._search(snapshot, q_emb, top_k, filters, text, mode)
+
+    def _search(self, snapshot: StoreSnapshot, q_emb: np.ndarray, top_k: int,
+                filters: Optional[QueryFilters], text: Optional[str], mode: str):
+        if len(snapshot) == 0:
+            return []
+
+        embeddings, catalog = snapshot.embeddings, snapshot.catalog
+
+        # Only rows passing the filter bitmap get scored
+        bitmap = catalog.compile(filters)
+        rows = None if bitmap is None else catalog.rows(bitmap)
+        if rows is not None and len(rows) == 0:
+            return []
+
+        # Long files score as their best window: max-pool the segment
+        # similarities per file, keeping the winning window's offset
+        n_rows = len(embeddings)
+        seg_best, seg_offset = (snapshot.segments.best_per_file(q_emb, n_rows, rows)
+                                if len(snapshot.segments)
+                                else (None, None))
+
+        def pooled(indices, sims):
+            return sims if seg_best is None else np.maximum(sims, seg_best[indices])
+
+        lex_docs = np.empty(0, dtype=np.int64)
+        lex_vals = np.empty(0, dtype=np.float32)
+        if mode == "hybrid" and text:
+            lex_docs, lex_vals = snapshot.lexical_index().search(text)
+            if rows is not None and len(lex_docs):
+                keep = np.isin(lex_docs, rows, assume_unique=True)
+                lex_docs, lex_vals = lex_docs[keep], lex_vals[keep]
+
+        if len(lex_docs) >= top_k:
+            # Exact terms matched enough files: only their vectors are scored
+            cand = lex_docs
+            sims = pooled(cand, cosine_similarity_matrix(q_emb, embeddings[cand]))
+            lex = lex_vals
+        else:
+            vectors = embeddings if rows is None else embeddings[rows]
+            all_sims = cosine_similarity_matrix(q_emb, vectors)
+            if seg_best is not None:
+                all_sims = np.maximum(all_sims, seg_best if rows is None else seg_best[rows])
+
+            # Semantic pool (partial sort), plus any lexical hits outside it
+            pool_size = min(len(all_sims), top_k if len(lex_docs) == 0 else max(top_k * 5, 100))
+            if pool_size <= 0:
+                return []
+            pool = np.argpartition(-all_sims, pool_size - 1)[:pool_size]
+            cand = pool if rows is None else rows[pool]
+            sims = all_sims[pool]
+            lex = np.zeros(len(cand), dtype=np.float32)
+
+            if len(lex_docs):
+                extra = np.setdiff1d(lex_docs, cand)
+                cand = np.concatenate([cand, extra])
+                sims = np.concatenate([sims, pooled(extra, cosine_similarity_matrix(q_emb, embeddings[extra]))])
+                lex = np.concatenate([lex, np.zeros(len(extra), dtype=np.float32)])
+                pos = np.searchsorted(lex_docs, cand).clip(max=len(lex_docs) - 1)
+                hit = lex_docs[pos] == cand
+                lex[hit] = lex_vals[pos[hit]]
+
+        # Candidates for the fusion in query(): the top k by similarity,
+        # which is all a shard without lexical hits can contribute, plus the
+        # best by local fusion, which holds any lexical hit that can place
+        k = min(top_k, len(sims))
+        if k <= 0:
+            return []
+        idxs = np.argpartition(-sims, k - 1)[:k]
+        if lex.any():
+            fused = reciprocal_rank_fusion(sims, lex)
+            n = min(len(fused), max(top_k * 5, 100))
+            idxs = np.union1d(idxs, np.argpartition(-fused, n - 1)[:n])
+        idxs = idxs[np.argsort(-sims[idxs])]
+
+        hits = []
+        for i in idxs:
+            vec_index = int(cand[i])
+            offset = 0.0
+            if seg_best is not None and seg_best[vec_index] >= sims[i]:
+                offset = float(seg_offset[vec_index])
+            hits.append((float(sims[i]), float(lex[i]), vec_index, catalog.paths[vec_index], offset,
+                         snapshot.descriptors(vec_index)))
+        return hits
+
+
+class LibraryRegistry:
+    """
+    The default store in data/ plus any registered library roots,
+    persisted in data/libraries.json. Shards whose root isn't mounted
+    are skipped and detached; they re-attach when the drive comes back.
+    """
+
+    def __init__(self):
+        self.stores: Dict[str, LibraryStore] = {
+            DEFAULT_LIBRARY: LibraryStore(DEFAULT_LIBRARY, None, DATA_DIR)
+        }
+
+        if os.path.exists(LIBRARIES_PATH):
+            with open(LIBRARIES_PATH) as f:
+                for lib in json.load(f):
+                    # A hand-edited file mustn't let "default" shadow data/
+                    if lib["name"] != DEFAULT_LIBRARY:
+                        self._add(lib["name"], lib["root"])
+
+    def _add(self, name: str, root: str):
+        root = os.path.normpath(root)
+        self.stores[name] = LibraryStore(name, root, os.path.join(root, LIBRARY_STORE_DIR))
+
+    def _save(self):
+        libs = [
+            {"name": s.name, "root": s.root}
+            for s in self.stores.values() if s.root is not None
+        ]
+        os.makedirs(DATA_DIR, exist_ok=True)
+        with open(LIBRARIES_PATH, "w") as f:
+            json.dump(libs, f, indent=2)
+
+    def register(self, name: str, root: Optional[str]):
+        """Raises ValueError for the reserved name or a root that isn't a directory."""
+        if not name or name == DEFAULT_LIBRARY:
+            raise ValueError(f"library name {name!r} is reserved")
+        if not root or not os.path.isdir(root):
+            raise ValueError(f"library root {root!r} is not a directory")
+        self._add(name, root)
+        self._save()
+
+    def unregister(self, name: str):
+        if name == DEFAULT_LIBRARY:
+            return
+        self.stores.pop(name, None)
+        self._save()
+
+    def mounted(self) -> List[LibraryStore]:
+        shards = []
+        for store in list(self.stores.values()):
+            if store.is_mounted():
+                store.attach()
+                shards.append(store)
+            elif store.attached:
+                store.detach()
+        return shards
+
+    def store_for(self, folder: str) -> LibraryStore:
+        for store in self.stores.values():
+            if store.contains(folder):
+                return store
+        return self.stores[DEFAULT_LIBRARY]
+
+    def describe(self):
+        return [
+            {"name": s.name, "root": s.root, "mounted": s.is_mounted()}
+            for s in self.stores.values()
+        ]
+
+
+# -----------------------------
+# Main Index Class
+# -----------------------------
+
+class SoundSiftIndex:
+    def __init__(self):
+        self.model = laion_clap.CLAP_Module(enable_fusion=False)
+        self.model.load_ckpt()
+
+        self.libraries = LibraryRegistry()
+        self.libraries.mounted()
+        self.pool = ThreadPoolExecutor(max_workers=os.cpu_count() or 4)
+        self.loaded = False
+        self.tag_vectors_cache: Optional[np.ndarray] = None
+
+        # Held by callers around query calls; HTTP and IPC requests arrive
+        # on different threads. Indexing doesn't take it: it serialises on
+        # index_lock and commits a new snapshot that queries pick up next.
+        self.lock = threading.RLock()
+        self.index_lock = threading.Lock()
+
+        if not os.path.exists(SUGGEST_PATH):
+            self.rebuild_suggestions()
+
+    # ---------- INDEXING ----------
+
+    def index_folder(self, folder: str, segments: bool = True):
+        with self.index_lock:
+            store = self.libraries.store_for(folder)
+            store.attach()
+            new_files = store.index_folder(folder, self.model, self.tag_vectors(), segments)
+            if new_files:
+                self.rebuild_suggestions()
+            self.loaded = False
+            return new_files
+
+    def tag_vectors(self) -> np.ndarray:
+        """Normalised text embeddings of the tag prompts, computed once per process."""
+        if self.tag_vectors_cache is None:
+            vectors = np.asarray(self.model.get_text_embedding(list(TAG_PROMPTS)), dtype=np.float32)
+            self.tag_vectors_cache = vectors / np.maximum(np.linalg.norm(vectors, axis=1, keepdims=True), 1e-12)
+        return self.tag_vectors_cache
+
+    def rebuild_suggestions(self):
+        """Type-ahead trie over path terms of every mounted library."""
+        def components():
+            for store in self.libraries.mounted():
+                for _, path, *_ in get_catalog(store.db_path):
+                    yield [path_to_text(part) for part in os.path.normpath(path).split(os.sep) if part]
+
+        os.makedirs(DATA_DIR, exist_ok=True)
+        write_suggest_trie(SUGGEST_PATH, count_terms(components()))
+
+    def index_version(self) -> str:
+        """
+        Changes whenever a mounted store is re-indexed or a library is
+        mounted or unmounted; clients use it to tell stale results apart.
+        """
+        parts = []
+        for store in self.libraries.mounted():
+            try:
+                st = os.stat(store.embeddings_path)
+                parts.append(f"{store.name}:{st.st_size}:{st.st_mtime_ns}")
+            except OSError:
+                parts.append(f"{store.name}:-")
+        return format(zlib.crc32("|".join(parts).encode("utf-8")), "08x")
+
+
+    # ---------- WARM-UP ----------
+
+    def ensure_loaded(self):
+        """
+        Page in every mounted store and run one throwaway text embedding so
+        the model's first-call setup happens here rather than in a query.
+        Indexing clears `loaded`, so the next call re-warms the new store.
+        """
+        if self.loaded:
+            return {}
+
+        t0 = time.perf_counter()
+        # Stores without current tag scores get them now; if an index run
+        # holds the lock, it writes them itself
+        if self.index_lock.acquire(blocking=False):
+            try:
+                for store in self.libraries.mounted():
+                    store.refresh_tags(self.tag_vectors)
+            finally:
+                self.index_lock.release()
+        tt = time.perf_counter()
+        rows = sum(self.pool.map(lambda store: store.warm(), self.libraries.mounted()))
+        t1 = time.perf_counter()
+        self.model.get_text_embedding(["warm up"])
+        t2 = time.perf_counter()
+
+        self.loaded = True
+        return {
+            "rows": rows,
+            "tags_ms": (tt - t0) * 1000.0,
+            "page_in_ms": (t1 - tt) * 1000.0,
+            "model_ms": (t2 - t1) * 1000.0,
+        }
 
     # Text embeddings
     def index_text(self, sample_id: int, path: str):
@@ -212,28 +795,107 @@ class SoundSiftIndex:
         self,
         text: str,
         top_k: int = 10,
+        filters: Optional[QueryFilters] = None,
+        timings: Optional[Dict[str, float]] = None,
+        mode: str = "hybrid",
     ):
+        """timings, if given, is filled with per-stage wall time in ms."""
+        timings = {} if timings is None else timings
+        t0 = time.perf_counter()
         
-        self.load()
-
-        if self.embeddings is None or len(self.embeddings) == 0:
+        shards = self.libraries.mounted()
+        if not shards:
             return []
+        tm = time.perf_counter()
         
-        # 1. Embed query text
+        # 1. Embed query text (once, shared by every shard)
         q_emb = self.model.get_text_embedding([text])[0]
+        t1 = time.perf_counter()
+
+        # 2. Fan out: each shard scans its own rows for candidates
+        per_shard = list(self.pool.map(
+            lambda store: [(sim, lex, store.name, i, path, offset, descriptors)
+                           for sim, lex, i, path, offset, descriptors
+                           in store.search(q_emb, top_k, filters, text, mode)],
+            shards
+        ))
+        t2 = time.perf_counter()
+
+        # 3. Merge, then score every candidate on one scale: hybrid always
+        # fuses (ranks over the union of shards), semantic is the similarity
+        candidates = [hit for hits in per_shard for hit in hits]
+        if not candidates:
+            return []
+        sims = np.array([hit[0] for hit in candidates], dtype=np.float32)
+        lex = np.array([hit[1] for hit in candidates], dtype=np.float32)
+        scores = reciprocal_rank_fusion(sims, lex) if mode == "hybrid" else sims
+        order = np.argsort(-scores, kind="stable")[:top_k]
+        best = [(float(scores[i]),) + candidates[i][:1] + candidates[i][2:] for i in order]
+        t3 = time.perf_counter()
+
+        # 4. Optional re-sort by a descriptor column
+        if filters is not None and filters.sort_by:
+            column = filters.sort_by.lstrip("-")
+            descending = filters.sort_by.startswith("-")
+            if column in DESCRIPTOR_COLUMNS:
+                def sort_key(hit):
+                    value = (hit[6] or {}).get(column)
+                    # Rows without the column go last either way
+                    if value is None:
+                        return (True, 0.0)
+                    return (False, -value if descending else value)
+                best.sort(key=sort_key)
+
+        timings["mount"] = (tm - t0) * 1000.0
+        timings["embed"] = (t1 - tm) * 1000.0
+        timings["scan"] = (t2 - t1) * 1000.0
+        timings["merge"] = (t3 - t2) * 1000.0
+
+        return [
+            {
+                "library": library,
+                "id": vec_index,
+                "score": score,
+                "similarity": sim,
+                "path": path,
+                "offset": offset,
+                "descriptors": descriptors,
+            }
+            for score, sim, library, vec_index, path, offset, descriptors in best
+        ]
+
+    # ---------- TAGS ----------
+
+    def tag_facets(self, filters: Optional[QueryFilters] = None) -> Dict[str, int]:
+        """Samples carrying each tag across mounted stores, within filters."""
+        counts = np.zeros(len(TAG_NAMES), dtype=np.int64)
+        for store in self.libraries.mounted():
+            with store.pinned() as snapshot:
+                counts += snapshot.tag_counts(filters)
+        return dict(zip(TAG_NAMES, counts.tolist()))
 
-        # 2. Similarity against audio
-        audio_sims = cosine_similarity_matrix(q_emb, self.embeddings)
+    def top_tagged(self, tag: str, top_k: int = 50, filters: Optional[QueryFilters] = None):
+        """The samples scoring highest for tag ("top snares"), shaped like query() results."""
+        if tag not in TAG_NAMES:
+            raise FilterError(f"unknown tag {tag!r}")
 
-        # 5. Rank
-        idxs = np.argsort(-audio_sims)[:top_k]
+        hits = []
+        for store in self.libraries.mounted():
+            with store.pinned() as snapshot:
+                hits += [(score, store.name, vec_index, path, descriptors)
+                         for score, vec_index, path, descriptors in snapshot.top_tagged(tag, top_k, filters)]
 
         return [
             {
-                "score": float(audio_sims[i]),
-                "path": get_sample_by_index(i),
+                "library": library,
+                "id": vec_index,
+                "score": score,
+                "similarity": score,
+                "path": path,
+                "offset": 0.0,
+                "descriptors": descriptors,
             }
-            for i in idxs
+            for score, library, vec_index, path, descriptors in heapq.nlargest(top_k, hits, key=lambda hit: hit[0])
         ]
 
 
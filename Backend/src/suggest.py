@@ -0,0 +1,110 @@
+import os
+import re
+import struct
+from typing import Dict, Iterable, List
+
+import numpy as np
+
+# -----------------------------
+# Config
+# -----------------------------
+
+SUGGEST_VERSION = 1
+HEADER_BYTES = 16
+MIN_TERM_LENGTH = 2
+
+# Terms in more than this share of files are path noise ("users", "samples")
+MAX_TERM_SHARE = 0.5
+
+NODE_DTYPE = np.dtype([
+    ("first_child", "<u4"),
+    ("child_count", "<u2"),
+    ("label", "u1"),
+    ("flags", "u1"),
+    ("count", "<u4"),
+    ("max_count", "<u4"),
+])
+
+TERMINAL = 1
+
+WORD_RE = re.compile(r"[a-z0-9#]+")
+
+
+# -----------------------------
+# Terms
+# -----------------------------
+
+def count_terms(component_texts: Iterable[List[str]]) -> Dict[str, int]:
+    """
+    Document frequency of words and in-component word pairs ("war drum"),
+    given the path_to_text of each path component, per file.
+    """
+    counts: Dict[str, int] = {}
+    n_files = 0
+
+    for components in component_texts:
+        n_files += 1
+        seen = set()
+        for text in components:
+            words = [w for w in WORD_RE.findall(text) if len(w) >= MIN_TERM_LENGTH]
+            seen.update(words)
+            seen.update(" ".join(pair) for pair in zip(words, words[1:]))
+        for term in seen:
+            counts[term] = counts.get(term, 0) + 1
+
+    limit = max(1, int(MAX_TERM_SHARE * n_files)) if n_files > 1 else n_files
+    return {t: c for t, c in counts.items() if c <= limit}
+
+
+# -----------------------------
+# Trie
+# -----------------------------
+
+def write_suggest_trie(out_path: str, counts: Dict[str, int]):
+    """
+    Byte-wise trie the plugin memory-maps for type-ahead (SuggestionIndex.h).
+
+    Layout: "SSTR", uint32 version, uint32 node count, 4 bytes pad, then
+    16-byte nodes in breadth-first order so every node's children are
+    contiguous and sorted by label. max_count is the highest count in a
+    node's subtree, which lets the reader walk best-first and stop after
+    k completions.
+    """
+    root: dict = {}
+    for term, count in counts.items():
+        node = root
+        for b in term.encode("utf-8"):
+            node = node.setdefault(b, {})
+        node[-1] = count
+
+    def subtree_max(node: dict) -> int:
+        best = node.get(-1, 0)
+        for label, child in node.items():
+            if label != -1:
+                best = max(best, subtree_max(child))
+        node[-2] = best
+        return best
+
+    subtree_max(root)
+
+    order = [(root, 0)]
+    records = []
+    i = 0
+    while i < len(order):
+        node, label = order[i]
+        children = sorted(k for k in node if k >= 0)
+        records.append((len(order), len(children), label,
+                        TERMINAL if -1 in node else 0,
+                        node.get(-1, 0), node[-2]))
+        order.extend((node[k], k) for k in children)
+        i += 1
+
+    nodes = np.array(records, dtype=NODE_DTYPE)
+
+    temp_path = out_path + ".tmp"
+    with open(temp_path, "wb") as f:
+        f.write(b"SSTR")
+        f.write(struct.pack("<II", SUGGEST_VERSION, len(nodes)))
+        f.write(b"\0" * (HEADER_BYTES - 12))
+        f.write(nodes.tobytes())
+    os.replace(temp_path, out_path)
@@ -0,0 +1,167 @@
+import os
+import struct
+import zlib
+from typing import Optional, Tuple
+
+import numpy as np
+
+# -----------------------------
+# Config
+# -----------------------------
+
+TAG_VERSION = 1
+HEADER_BYTES = 20
+NAME_BYTES = 16
+
+# (name, prompt): names are what filters and facets use, prompts are what
+# gets embedded. Column order is the file format; changing a prompt
+# changes VOCABULARY_ID, and stores rescore on their next load.
+TAGS = (
+    ("kick", "a kick drum hit"),
+    ("snare", "a snare drum hit"),
+    ("clap", "a hand clap"),
+    ("hihat", "a hi-hat cymbal"),
+    ("cymbal", "a crash or ride cymbal"),
+    ("tom", "a tom drum"),
+    ("percussion", "a percussion hit such as a shaker, conga or woodblock"),
+    ("808", "an 808 bass drum"),
+    ("drum_loop", "a drum loop"),
+    ("bass", "a bass synth or bass guitar"),
+    ("sub", "a deep sub bass"),
+    ("pad", "an ambient synth pad"),
+    ("lead", "a synth lead melody"),
+    ("pluck", "a plucked synth"),
+    ("chord", "a chord stab"),
+    ("arp", "an arpeggiated synth"),
+    ("keys", "a piano or electric piano"),
+    ("guitar", "a guitar"),
+    ("strings", "an orchestral string section"),
+    ("brass", "brass instruments"),
+    ("woodwind", "a flute or woodwind instrument"),
+    ("bell", "a bell or chime"),
+    ("vocal", "a human voice singing"),
+    ("vocal_chop", "a chopped vocal sample"),
+    ("speech", "a person speaking"),
+    ("riser", "a rising sweep riser effect"),
+    ("downlifter", "a falling downlifter effect"),
+    ("impact", "a cinematic impact hit"),
+    ("whoosh", "a whoosh transition"),
+    ("noise", "white noise"),
+    ("texture", "an atmospheric texture"),
+    ("foley", "a foley sound effect"),
+    ("ambience", "a field recording ambience"),
+    ("glitch", "a glitchy digital sound effect"),
+    ("vinyl", "vinyl crackle"),
+)
+
+NAMES = tuple(name for name, _ in TAGS)
+PROMPTS = tuple(prompt for _, prompt in TAGS)
+VOCABULARY_ID = zlib.crc32("\n".join(f"{n}\t{p}" for n, p in TAGS).encode("utf-8"))
+
+# Zero-shot scores are only comparable within a row, so a sample carries
+# its best tag plus any others within TAG_MARGIN of it
+TAG_MARGIN = 0.03
+MAX_TAGS_PER_ROW = 3
+
+# Bits set per byte, for counting packed bitmaps
+POPCOUNT = np.array([bin(b).count("1") for b in range(256)], dtype=np.int64)
+
+
+def score_rows(embeddings: np.ndarray, tag_vectors: np.ndarray, chunk: int = 1 << 14) -> np.ndarray:
+    """Cosine of every (normalised) row against every tag vector, as float16."""
+    scores = np.empty((len(embeddings), len(NAMES)), dtype=np.float16)
+    for start in range(0, len(embeddings), chunk):
+        rows = np.asarray(embeddings[start:start + chunk], dtype=np.float32)
+        scores[start:start + len(rows)] = rows @ tag_vectors.T
+    return scores
+
+
+# -----------------------------
+# Sidecar
+# -----------------------------
+
+def header_bytes() -> int:
+    return HEADER_BYTES + NAME_BYTES * len(NAMES)
+
+
+def write_tags(out_path: str, scores: np.ndarray):
+    """
+    tags.bin: "SSTG", uint32 version, uint32 rows, uint32 tags, uint32
+    vocabulary id, one 16-byte tag name each, then rows x tags float16
+    scores row by row, so new rows append.
+    """
+    temp_path = out_path + ".tmp"
+    with open(temp_path, "wb") as f:
+        f.write(b"SSTG")
+        f.write(struct.pack("<IIII", TAG_VERSION, len(scores), len(NAMES), VOCABULARY_ID))
+        for name in NAMES:
+            f.write(name.encode("ascii").ljust(NAME_BYTES, b"\0"))
+        f.write(np.ascontiguousarray(scores, dtype="<f2").tobytes())
+    os.replace(temp_path, out_path)
+
+
+class TagTable:
+    """
+    Memory-mapped view of tags.bin. A missing file or one written for
+    another vocabulary reads as empty; rows past the file score -inf and
+    carry no tags.
+    """
+
+    def __init__(self, path: str, n_rows: int):
+        self.n_rows = n_rows
+        self.scores = np.zeros((0, len(NAMES)), dtype=np.float16)
+        self.assigned: Optional[np.ndarray] = None
+
+        if os.path.exists(path) and os.path.getsize(path) >= header_bytes():
+            with open(path, "rb") as f:
+                magic, version, rows, tags, vocabulary = struct.unpack("<4sIIII", f.read(HEADER_BYTES))
+            if (magic == b"SSTG" and version == TAG_VERSION and tags == len(NAMES)
+                    and vocabulary == VOCABULARY_ID and rows > 0
+                    and os.path.getsize(path) >= header_bytes() + rows * tags * 2):
+                self.scores = np.memmap(path, dtype="<f2", mode="r", offset=header_bytes(),
+                                        shape=(rows, tags))
+
+    def __len__(self):
+        return len(self.scores)
+
+    def grown(self, n_rows: int) -> Tuple[np.ndarray, int]:
+        """Copy resized to n_rows and the number of rows already scored."""
+        table = np.zeros((n_rows, len(NAMES)), dtype=np.float16)
+        n = min(len(self.scores), n_rows)
+        table[:n] = self.scores[:n]
+        return table, n
+
+    def column(self, name: str) -> np.ndarray:
+        col = np.full(self.n_rows, -np.inf, dtype=np.float32)
+        n = min(len(self.scores), self.n_rows)
+        col[:n] = self.scores[:n, NAMES.index(name)]
+        return col
+
+    def tagged(self, name: str) -> np.ndarray:
+        """Bool per row: whether the row carries the tag."""
+        if self.assigned is None:
+            self.assigned = self._assign()
+        return self.assigned[:, NAMES.index(name)]
+
+    def _assign(self, chunk: int = 1 << 14) -> np.ndarray:
+        assigned = np.zeros((self.n_rows, len(NAMES)), dtype=bool)
+        n = min(len(self.scores), self.n_rows)
+        for start in range(0, n, chunk):
+            scores = np.asarray(self.scores[start:min(start + chunk, n)], dtype=np.float32)
+            best = scores.max(axis=1, keepdims=True)
+            # Rank within the row, so ties at the margin can't exceed the cap
+            rank = np.argsort(np.argsort(-scores, axis=1), axis=1)
+            # Rows that failed to embed are all zeros: no tags
+            assigned[start:start + len(scores)] = ((scores >= best - TAG_MARGIN) & (rank < MAX_TAGS_PER_ROW)
+                                                   & (best > 0.0))
+        return assigned
+
+    def top(self, name: str, k: int, rows: np.ndarray) -> Tuple[np.ndarray, np.ndarray]:
+        """Best k of rows by the tag's score, highest first."""
+        scores = self.column(name)[rows]
+        k = min(k, len(scores))
+        if k <= 0:
+            return np.empty(0, dtype=np.int64), np.empty(0, dtype=np.float32)
+        idxs = np.argpartition(-scores, k - 1)[:k]
+        idxs = idxs[np.argsort(-scores[idxs])]
+        return rows[idxs], scores[idxs]
@@ -1,9 +1,20 @@
 #pragma once
 #include <JuceHeader.h>
+#include "SearchTrace.h"
+#include "IpcTransport.h"
 
 class ApiClient
 {
 public:
+    struct SearchResult
+    {
+        juce::String path;
+        juce::String library;
+        int id = -1;
+        float score = 0.0f;
+        float offset = 0.0f;  // seconds to the best matching window of a long file
+    };
+    
     ApiClient(const juce::String& baseUrl = "http://localhost:8000")
         : baseUrl(baseUrl) {}
     
@@ -17,21 +28,146 @@ public:
     
     void queryText(const juce::String& queryText, int topK,
                    std::function<void(bool, juce::var)> callback)
+    {
+        this->queryText(queryText, topK, juce::var(), callback);
+    }
+    
+    // filters is an object matching the server's QueryFilters
+    // (min_duration, max_duration, folder, extensions, indexed_after)
+    void queryText(const juce::String& queryText, int topK, const juce::var& filters,
+                   std::function<void(bool, juce::var)> callback)
     {
         juce::DynamicObject::Ptr json = new juce::DynamicObject();
         json->setProperty("text", queryText);
         json->setProperty("top_k", topK);
+        if (filters.isObject())
+            json->setProperty("filters", filters);
         sendPostRequest("/query/text", json, callback);
     }
     
+    // Best-scoring samples for one zero-shot tag ("top snares"), within
+    // filters; the response is shaped like /query/text's
+    void topTagged(const juce::String& tag, int topK, const juce::var& filters,
+                   std::function<void(bool, juce::var)> callback)
+    {
+        juce::DynamicObject::Ptr json = new juce::DynamicObject();
+        json->setProperty("tag", tag);
+        json->setProperty("top_k", topK);
+        if (filters.isObject())
+            json->setProperty("filters", filters);
+        sendPostRequest("/tags/top", json, callback);
+    }
+    
+    // Server health and the locations of sidecar files the plugin maps
+    // directly ("data_dir", "suggestions")
+    void getStatus(std::function<void(bool, juce::var)> callback)
+    {
+        juce::DynamicObject::Ptr json = new juce::DynamicObject();
+        sendPostRequest("/status", json, callback);
+    }
+    
     void loadIndex(std::function<void(bool, juce::var)> callback)
     {
         auto json = new juce::DynamicObject();
         sendPostRequest("/load", json, callback);
     }
     
+    // Every request records spans into trace when one is set
+    void setTrace(std::shared_ptr<SearchTrace> newTrace)
+    {
+        trace = std::move(newTrace);
+    }
+    
+    // Requests run as jobs on pool instead of a thread each. The pool
+    // must outlive any request in flight.
+    void setWorkers(juce::ThreadPool* pool)
+    {
+        workers = pool;
+    }
+    
+    // Queries go over transport whenever it's connected, and fall back
+    // to HTTP (dropping the connection) if a request over it fails
+    void setIpc(std::shared_ptr<IpcTransport> transport)
+    {
+        ipc = std::move(transport);
+    }
+    
+    // Unpacks the "results" array of a /query/text response. Plain string
+    // entries are accepted as bare paths.
+    static juce::Array<SearchResult> decodeResults(const juce::var& response)
+    {
+        juce::Array<SearchResult> results;
+        auto* array = response["results"].getArray();
+        
+        if (array == nullptr)
+            return results;
+        
+        results.ensureStorageAllocated(array->size());
+        
+        for (auto& item : *array)
+        {
+            SearchResult result;
+            
+            if (item.isObject() && item.hasProperty("path"))
+            {
+                result.path = item["path"].toString();
+                result.library = item["library"].toString();
+                result.id = item.getProperty("id", -1);
+                result.score = (float) (double) item.getProperty("score", 0.0);
+                result.offset = (float) (double) item.getProperty("offset", 0.0);
+            }
+            else if (item.isString())
+            {
+                result.path = item.toString();
+            }
+            else
+            {
+                continue;
+            }
+            
+            results.add(result);
+        }
+        
+        return results;
+    }
+    
 private:
     juce::String baseUrl;
+    std::shared_ptr<SearchTrace> trace;
+    juce::ThreadPool* workers = nullptr;
+    std::shared_ptr<IpcTransport> ipc;
+    
+    // Server stage timings arrive as "Server-Timing: embed;dur=12.1, scan;dur=3.4".
+    // The server clock isn't ours, so the stages are laid out back to back
+    // ending when the response was read.
+    static void addServerSpans(SearchTrace& trace, int traceId,
+                               const juce::String& header, juce::int64 responseEnd)
+    {
+        juce::StringArray names;
+        juce::Array<juce::int64> durations;
+        juce::int64 total = 0;
+        
+        for (auto& entry : juce::StringArray::fromTokens(header, ",", ""))
+        {
+            auto name = entry.upToFirstOccurrenceOf(";", false, false).trim();
+            auto dur = entry.fromFirstOccurrenceOf("dur=", false, true).getDoubleValue();
+            
+            if (name.isEmpty() || name == "total")
+                continue;
+            
+            names.add(name);
+            durations.add((juce::int64) (dur * 1000.0));
+            total += durations.getLast();
+        }
+        
+        auto start = responseEnd - total;
+        
+        for (int i = 0; i < names.size(); ++i)
+        {
+            trace.addSpan(traceId, names[i], "server", start, start + durations[i]);
+            start += durations[i];
+        }
+    }
     
     void sendPostRequest(const juce::String& endpoint,
                         juce::DynamicObject::Ptr jsonData,
@@ -40,18 +176,26 @@ private:
         juce::String jsonString = juce::JSON::toString(juce::var(jsonData.get()));
         juce::String fullUrl = baseUrl + endpoint;
         
-        juce::Thread::launch([fullUrl, jsonString, callback]()
+        auto trace = this->trace;
+        auto traceId = trace != nullptr ? trace->beginTrace() : 0;
+        auto requestStart = SearchTrace::nowMicros();
+        
+        std::function<void()> request = [fullUrl, endpoint, jsonString, callback, trace, traceId, requestStart]()
         {
+            auto threadStart = SearchTrace::nowMicros();
+            
             juce::URL url(fullUrl);
             url = url.withPOSTData(jsonString);
             
             int statusCode = 0;
+            juce::StringPairArray responseHeaders;
             
             auto stream = url.createInputStream(
                 juce::URL::InputStreamOptions(juce::URL::ParameterHandling::inPostData)
                     .withExtraHeaders("Content-Type: application/json")
                     .withConnectionTimeoutMs(30000)
                     .withStatusCode(&statusCode)
+                    .withResponseHeaders(&responseHeaders)
             );
             
             bool success = (stream != nullptr && statusCode == 200);
@@ -60,14 +204,99 @@ private:
             if (stream != nullptr)
                 responseText = stream->readEntireStreamAsString();
             
-            juce::MessageManager::callAsync([callback, success, responseText]()
+            auto responseEnd = SearchTrace::nowMicros();
+            
+            if (trace != nullptr)
+            {
+                trace->addSpan(traceId, "spawn", "client", requestStart, threadStart);
+                trace->addSpan(traceId, "http " + endpoint, "client", threadStart, responseEnd);
+                addServerSpans(*trace, traceId, responseHeaders["Server-Timing"], responseEnd);
+            }
+            
+            juce::MessageManager::callAsync([endpoint, callback, success, responseText,
+                                             trace, traceId, requestStart, responseEnd]()
             {
+                auto dispatched = SearchTrace::nowMicros();
+                
+                // Error replies are parsed too: a 400 carries its "detail"
                 juce::var parsedJson;
-                if (success)
-                    juce::JSON::parse(responseText, parsedJson);
+                juce::JSON::parse(responseText, parsedJson);
+                
+                auto parsed = SearchTrace::nowMicros();
+                
+                // Latency counts up to the point results are ready for the UI,
+                // so the callback can already show it
+                if (trace != nullptr && endpoint == "/query/text")
+                    trace->addLatency(parsed - requestStart);
                     
                 callback(success, parsedJson);
+                
+                if (trace != nullptr)
+                {
+                    auto done = SearchTrace::nowMicros();
+                    trace->addSpan(traceId, "callAsync", "client", responseEnd, dispatched);
+                    trace->addSpan(traceId, "JSON::parse", "client", dispatched, parsed);
+                    trace->addSpan(traceId, "callback", "ui", parsed, done);
+                    trace->addSpan(traceId, endpoint, "request", requestStart, done);
+                }
             });
-        });
+        };
+        
+        if (endpoint == "/query/text" && ipc != nullptr && ipc->isConnected())
+        {
+            auto http = std::move(request);
+            
+            request = [ipc = this->ipc, http, endpoint, jsonString, callback, trace, traceId, requestStart]()
+            {
+                auto threadStart = SearchTrace::nowMicros();
+                
+                juce::var response;
+                juce::String serverTiming;
+                auto outcome = ipc->query(jsonString, response, serverTiming);
+                
+                if (outcome == IpcTransport::Outcome::failed)
+                {
+                    ipc->disconnect();
+                    http();
+                    return;
+                }
+                
+                auto responseEnd = SearchTrace::nowMicros();
+                
+                if (trace != nullptr)
+                {
+                    trace->addSpan(traceId, "spawn", "client", requestStart, threadStart);
+                    trace->addSpan(traceId, "ipc " + endpoint, "client", threadStart, responseEnd);
+                    addServerSpans(*trace, traceId, serverTiming, responseEnd);
+                }
+                
+                // A rejected request fails like an HTTP 400, with its "detail"
+                auto success = outcome == IpcTransport::Outcome::answered;
+                
+                juce::MessageManager::callAsync([endpoint, callback, response, success,
+                                                 trace, traceId, requestStart, responseEnd]()
+                {
+                    auto dispatched = SearchTrace::nowMicros();
+                    
+                    if (trace != nullptr)
+                        trace->addLatency(dispatched - requestStart);
+                    
+                    callback(success, response);
+                    
+                    if (trace != nullptr)
+                    {
+                        auto done = SearchTrace::nowMicros();
+                        trace->addSpan(traceId, "callAsync", "client", responseEnd, dispatched);
+                        trace->addSpan(traceId, "callback", "ui", dispatched, done);
+                        trace->addSpan(traceId, endpoint, "request", requestStart, done);
+                    }
+                });
+            };
+        }
+        
+        if (workers != nullptr)
+            workers->addJob(std::move(request));
+        else
+            juce::Thread::launch(std::move(request));
     }
 };
@@ -0,0 +1,218 @@
+#pragma once
+#include <JuceHeader.h>
+
+// What processBlock costs, measured on the audio thread and read from
+// anywhere else without locks. The audio thread is the only writer: every
+// field is an atomic it stores with relaxed ordering, so recording never
+// waits, and readers (the editor's meter, writeReport) never block it.
+// A snapshot can mix fields from adjacent blocks, which is fine for a
+// meter and a report.
+//
+// Load is processing time over the block's deadline (numSamples / rate);
+// an overrun is a block that used more than its deadline.
+class AudioPerfMonitor
+{
+public:
+    static constexpr int histogramBuckets = 12;  // 10 % each, the last one is >= 110 %
+    static constexpr int historySize = 4096;     // recent blocks kept for the report
+
+    struct Stats
+    {
+        juce::uint64 blocks = 0;
+        juce::uint64 overruns = 0;
+        juce::uint64 diskUnderruns = 0;   // streamed preview not buffered in time
+        juce::uint64 starvedNotes = 0;    // kit notes that arrived before their sample
+        float lastLoad = 0.0f;
+        float averageLoad = 0.0f;         // smoothed over roughly the last second
+        float peakLoad = 0.0f;            // since the previous takePeakLoad()
+        double worstBlockMs = 0.0;
+        double sampleRate = 0.0;
+        int blockSize = 0;
+        std::array<juce::uint64, histogramBuckets> histogram {};
+    };
+
+    // Times one processBlock call from construction to destruction
+    class ScopedBlock
+    {
+    public:
+        ScopedBlock(AudioPerfMonitor& m, int samples)
+            : monitor(m), numSamples(samples), start(juce::Time::getHighResolutionTicks()) {}
+
+        ~ScopedBlock() { monitor.recordBlock(numSamples, juce::Time::getHighResolutionTicks() - start); }
+
+    private:
+        AudioPerfMonitor& monitor;
+        int numSamples;
+        juce::int64 start;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedBlock)
+    };
+
+    // ---------- AUDIO THREAD ----------
+
+    void prepare(double newSampleRate, int newBlockSize)
+    {
+        sampleRate.store(newSampleRate, std::memory_order_relaxed);
+        blockSize.store(newBlockSize, std::memory_order_relaxed);
+    }
+
+    void recordBlock(int numSamples, juce::int64 elapsedTicks)
+    {
+        auto rate = sampleRate.load(std::memory_order_relaxed);
+        if (rate <= 0.0 || numSamples <= 0)
+            return;
+
+        auto seconds = juce::Time::highResolutionTicksToSeconds(elapsedTicks);
+        auto load = (float) (seconds * rate / numSamples);
+
+        // One-pole smoothing with a time constant of about a second of audio
+        auto alpha = (float) juce::jmin(1.0, numSamples / rate);
+        auto average = averageLoad.load(std::memory_order_relaxed);
+        averageLoad.store(average + alpha * (load - average), std::memory_order_relaxed);
+
+        lastLoad.store(load, std::memory_order_relaxed);
+        if (load > peakLoad.load(std::memory_order_relaxed))
+            peakLoad.store(load, std::memory_order_relaxed);
+        if (seconds * 1000.0 > worstBlockMs.load(std::memory_order_relaxed))
+            worstBlockMs.store(seconds * 1000.0, std::memory_order_relaxed);
+
+        if (load > 1.0f)
+            overruns.fetch_add(1, std::memory_order_relaxed);
+
+        auto bucket = juce::jlimit(0, histogramBuckets - 1, (int) (load * 10.0f));
+        histogram[(size_t) bucket].fetch_add(1, std::memory_order_relaxed);
+
+        auto index = blocks.fetch_add(1, std::memory_order_relaxed);
+        auto& entry = history[(size_t) (index % historySize)];
+        entry.startTicks.store(juce::Time::getHighResolutionTicks() - elapsedTicks, std::memory_order_relaxed);
+        entry.elapsedTicks.store(elapsedTicks, std::memory_order_relaxed);
+        entry.numSamples.store(numSamples, std::memory_order_relaxed);
+    }
+
+    void recordDiskUnderrun() { diskUnderruns.fetch_add(1, std::memory_order_relaxed); }
+    void recordStarvedNote() { starvedNotes.fetch_add(1, std::memory_order_relaxed); }
+
+    // ---------- READERS ----------
+
+    Stats getStats() const
+    {
+        Stats stats;
+        stats.blocks = blocks.load(std::memory_order_relaxed);
+        stats.overruns = overruns.load(std::memory_order_relaxed);
+        stats.diskUnderruns = diskUnderruns.load(std::memory_order_relaxed);
+        stats.starvedNotes = starvedNotes.load(std::memory_order_relaxed);
+        stats.lastLoad = lastLoad.load(std::memory_order_relaxed);
+        stats.averageLoad = averageLoad.load(std::memory_order_relaxed);
+        stats.peakLoad = peakLoad.load(std::memory_order_relaxed);
+        stats.worstBlockMs = worstBlockMs.load(std::memory_order_relaxed);
+        stats.sampleRate = sampleRate.load(std::memory_order_relaxed);
+        stats.blockSize = blockSize.load(std::memory_order_relaxed);
+
+        for (size_t i = 0; i < histogram.size(); ++i)
+            stats.histogram[i] = histogram[i].load(std::memory_order_relaxed);
+
+        return stats;
+    }
+
+    // Peak load since the last call, for a meter that shows short spikes.
+    // The audio thread may overwrite the reset with an older peak; the
+    // next read catches up.
+    float takePeakLoad()
+    {
+        return peakLoad.exchange(0.0f, std::memory_order_relaxed);
+    }
+
+    // Summary, load histogram and the most recent blocks as JSON
+    bool writeReport(const juce::File& file) const
+    {
+        auto stats = getStats();
+
+        juce::DynamicObject::Ptr report = new juce::DynamicObject();
+        report->setProperty("sample_rate", stats.sampleRate);
+        report->setProperty("block_size", stats.blockSize);
+        report->setProperty("blocks", (juce::int64) stats.blocks);
+        report->setProperty("overruns", (juce::int64) stats.overruns);
+        report->setProperty("disk_underruns", (juce::int64) stats.diskUnderruns);
+        report->setProperty("starved_notes", (juce::int64) stats.starvedNotes);
+        report->setProperty("average_load", stats.averageLoad);
+        report->setProperty("worst_block_ms", stats.worstBlockMs);
+
+        juce::Array<juce::var> buckets;
+        for (auto count : stats.histogram)
+            buckets.add((juce::int64) count);
+        report->setProperty("load_histogram_10pct", buckets);
+
+        // [start ms, elapsed ms, samples, load] per block, oldest first
+        juce::Array<juce::var> recent;
+        auto count = (juce::uint64) juce::jmin<juce::uint64>(stats.blocks, (juce::uint64) historySize);
+        auto rate = juce::jmax(1.0, stats.sampleRate);
+
+        for (auto i = stats.blocks - count; i < stats.blocks; ++i)
+        {
+            auto& entry = history[(size_t) (i % historySize)];
+            auto elapsed = juce::Time::highResolutionTicksToSeconds(entry.elapsedTicks.load(std::memory_order_relaxed));
+            auto samples = entry.numSamples.load(std::memory_order_relaxed);
+
+            recent.add(juce::Array<juce::var> {
+                juce::Time::highResolutionTicksToSeconds(entry.startTicks.load(std::memory_order_relaxed)) * 1000.0,
+                elapsed * 1000.0,
+                samples,
+                samples > 0 ? elapsed * rate / samples : 0.0
+            });
+        }
+        report->setProperty("recent_blocks", recent);
+
+        return file.replaceWithText(juce::JSON::toString(juce::var(report.get())));
+    }
+
+private:
+    struct BlockRecord
+    {
+        std::atomic<juce::int64> startTicks { 0 };
+        std::atomic<juce::int64> elapsedTicks { 0 };
+        std::atomic<int> numSamples { 0 };
+    };
+
+    std::atomic<double> sampleRate { 0.0 };
+    std::atomic<int> blockSize { 0 };
+
+    std::atomic<juce::uint64> blocks { 0 };
+    std::atomic<juce::uint64> overruns { 0 };
+    std::atomic<juce::uint64> diskUnderruns { 0 };
+    std::atomic<juce::uint64> starvedNotes { 0 };
+    std::atomic<float> lastLoad { 0.0f };
+    std::atomic<float> averageLoad { 0.0f };
+    std::atomic<float> peakLoad { 0.0f };
+    std::atomic<double> worstBlockMs { 0.0 };
+    std::array<std::atomic<juce::uint64>, histogramBuckets> histogram {};
+    std::array<BlockRecord, historySize> history;
+};
+
+// Read-ahead buffer for streamed previews that tells the monitor whenever
+// the disk thread hasn't filled the block being played. While offline is
+// set (the host is bouncing faster than realtime) it waits for the disk
+// instead, up to offlineWaitMs per block.
+class MonitoredBufferingSource : public juce::BufferingAudioSource
+{
+public:
+    static constexpr juce::uint32 offlineWaitMs = 1000;
+
+    MonitoredBufferingSource(juce::PositionableAudioSource* source, juce::TimeSliceThread& thread,
+                             int bufferSamples, int numChannels, AudioPerfMonitor& m,
+                             const std::atomic<bool>& renderingOffline)
+        : juce::BufferingAudioSource(source, thread, true, bufferSamples, numChannels),
+          monitor(m), offline(renderingOffline) {}
+
+    void getNextAudioBlock(const juce::AudioSourceChannelInfo& info) override
+    {
+        // Zero timeout in realtime: only asks whether the range is buffered
+        if (! waitForNextAudioBlockReady(info, offline.load(std::memory_order_relaxed) ? offlineWaitMs : 0))
+            monitor.recordDiskUnderrun();
+
+        juce::BufferingAudioSource::getNextAudioBlock(info);
+    }
+
+private:
+    AudioPerfMonitor& monitor;
+    const std::atomic<bool>& offline;
+};
@@ -45,6 +45,14 @@ public:
         repaint();
     }
     
+    // Same, for a search result: trimmed and levelled by the processor
+    void loadResult(const ApiClient::SearchResult& result)
+    {
+        processor.loadResult(result);
+        currentFile = juce::File(result.path);
+        repaint();
+    }
+    
     // Note: prepareToPlay, getNextAudioBlock, and releaseResources were removed.
     // They are no longer needed here because the Processor handles the audio now.
     
@@ -77,7 +85,7 @@ public:
                 case Stopped:
                     stopButton.setEnabled (false);
                     playButton.setEnabled (true);
-                    processor.transportSource.setPosition (0.0);
+                    processor.transportSource.setPosition (processor.getPreviewStart());
                     break;
                     
                 case Starting:
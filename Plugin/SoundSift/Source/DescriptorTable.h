@@ -0,0 +1,109 @@
+#pragma once
+#include <JuceHeader.h>
+
+// Read-only view of the descriptors.bin sidecar the backend's analyser
+// writes next to embeddings.bin (Backend/src/descriptors.py): loudness,
+// silence and rhythm per vec_index, so preview can trim and level a sample
+// without opening the audio file.
+//
+// Layout (little endian):
+//   char[4]  "SSDC"
+//   uint32   version
+//   uint32   rows
+//   uint32   column count
+//   char[16] names[column count]   NUL-padded ASCII
+//   float32  columns[column count][rows]
+class DescriptorTable
+{
+public:
+    // Missing or unanalysed values are NaN
+    struct Row
+    {
+        float peakDb = std::numeric_limits<float>::quiet_NaN();
+        float rmsDb = std::numeric_limits<float>::quiet_NaN();
+        float lufs = std::numeric_limits<float>::quiet_NaN();
+        float leadingSilence = std::numeric_limits<float>::quiet_NaN();
+        float onsetCount = std::numeric_limits<float>::quiet_NaN();
+        float centroidHz = std::numeric_limits<float>::quiet_NaN();
+        float bpm = std::numeric_limits<float>::quiet_NaN();
+    };
+
+    DescriptorTable() = default;
+    explicit DescriptorTable(const juce::File& file) { open(file); }
+
+    bool open(const juce::File& file)
+    {
+        rows = 0;
+        std::fill(std::begin(columns), std::end(columns), nullptr);
+        mapped = std::make_unique<juce::MemoryMappedFile>(file, juce::MemoryMappedFile::readOnly);
+
+        auto* data = static_cast<const char*>(mapped->getData());
+        auto size = mapped->getSize();
+
+        if (data == nullptr || size < headerBytes || std::memcmp(data, "SSDC", 4) != 0
+            || juce::ByteOrder::littleEndianInt(data + 4) != version)
+        {
+            mapped.reset();
+            return false;
+        }
+
+        auto n = (size_t) juce::ByteOrder::littleEndianInt(data + 8);
+        auto columnCount = (size_t) juce::ByteOrder::littleEndianInt(data + 12);
+        auto dataStart = headerBytes + columnCount * nameBytes;
+
+        if (dataStart + columnCount * n * sizeof(float) > size)
+        {
+            mapped.reset();
+            return false;
+        }
+
+        // Columns are found by name, so the backend can append new ones
+        auto* values = reinterpret_cast<const float*>(data + dataStart);
+
+        for (size_t c = 0; c < columnCount; ++c)
+        {
+            auto name = juce::String(data + headerBytes + c * nameBytes, nameBytes);
+
+            for (int known = 0; known < numColumns; ++known)
+                if (name == columnNames[known])
+                    columns[known] = values + c * n;
+        }
+
+        rows = (int) n;
+        return true;
+    }
+
+    bool isOpen() const { return mapped != nullptr; }
+    int size() const { return rows; }
+
+    Row operator[](int vecIndex) const
+    {
+        Row row;
+
+        if (vecIndex < 0 || vecIndex >= rows)
+            return row;
+
+        float* fields[numColumns] = { &row.peakDb, &row.rmsDb, &row.lufs, &row.leadingSilence,
+                                      &row.onsetCount, &row.centroidHz, &row.bpm };
+
+        for (int c = 0; c < numColumns; ++c)
+            if (columns[c] != nullptr)
+                *fields[c] = columns[c][vecIndex];
+
+        return row;
+    }
+
+private:
+    static constexpr size_t headerBytes = 16;
+    static constexpr size_t nameBytes = 16;
+    static constexpr juce::uint32 version = 1;
+    static constexpr int numColumns = 7;
+
+    static constexpr const char* columnNames[numColumns] = {
+        "peak_db", "rms_db", "lufs", "leading_silence", "onset_count", "centroid_hz", "bpm"
+    };
+
+    std::unique_ptr<juce::MemoryMappedFile> mapped;
+    const float* columns[numColumns] = {};
+    int rows = 0;
+};
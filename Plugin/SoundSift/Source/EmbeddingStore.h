@@ -0,0 +1,136 @@
+#pragma once
+#include <JuceHeader.h>
+
+// Read-only view of an embeddings.bin store written by the backend:
+// one row of `dim` normalised float32 values per vec_index. The file is
+// memory mapped, so opening is cheap and pages come in as the scan
+// touches them.
+class EmbeddingStore
+{
+public:
+    static constexpr int dim = 512;
+
+    struct Hit
+    {
+        float score;
+        int index;
+    };
+
+    EmbeddingStore() = default;
+    explicit EmbeddingStore(const juce::File& file) { open(file); }
+
+    bool open(const juce::File& file)
+    {
+        numRows = 0;
+        mapped = std::make_unique<juce::MemoryMappedFile>(file, juce::MemoryMappedFile::readOnly);
+
+        if (mapped->getData() == nullptr)
+        {
+            mapped.reset();
+            return false;
+        }
+
+        numRows = (int) (mapped->getSize() / rowBytes());
+        return true;
+    }
+
+    bool isOpen() const { return mapped != nullptr; }
+    int size() const { return numRows; }
+    size_t sizeInBytes() const { return (size_t) numRows * rowBytes(); }
+    static constexpr size_t rowBytes() { return dim * sizeof(float); }
+
+    const float* row(int index) const
+    {
+        jassert(index >= 0 && index < numRows);
+        return static_cast<const float*>(mapped->getData()) + (size_t) index * dim;
+    }
+
+    // Rows are normalised on write, so the dot product is the cosine
+    // similarity. Four accumulators keep the adds independent so the
+    // loop vectorises.
+    static float dot(const float* a, const float* b)
+    {
+        float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f;
+
+        for (int i = 0; i < dim; i += 4)
+        {
+            s0 += a[i]     * b[i];
+            s1 += a[i + 1] * b[i + 1];
+            s2 += a[i + 2] * b[i + 2];
+            s3 += a[i + 3] * b[i + 3];
+        }
+
+        return (s0 + s1) + (s2 + s3);
+    }
+
+    // Writes the score of every row in [begin, end) to scores[0 .. end - begin)
+    void scoreRows(const float* query, int begin, int end, float* scores) const
+    {
+        for (int i = begin; i < end; ++i)
+            scores[i - begin] = dot(query, row(i));
+    }
+
+    // Best topK of n precomputed scores, highest first
+    static std::vector<Hit> selectTopK(const float* scores, int n, int topK)
+    {
+        TopK best(topK);
+
+        for (int i = 0; i < n; ++i)
+            best.push(scores[i], i);
+
+        return best.sorted();
+    }
+
+    // Scan and select in one pass, without a score buffer
+    std::vector<Hit> search(const float* query, int topK) const
+    {
+        return search(query, topK, 0, numRows);
+    }
+
+    std::vector<Hit> search(const float* query, int topK, int begin, int end) const
+    {
+        TopK best(topK);
+
+        for (int i = begin; i < end; ++i)
+            best.push(dot(query, row(i)), i);
+
+        return best.sorted();
+    }
+
+private:
+    // Bounded min-heap: the root is the weakest hit kept so far, so most
+    // rows are rejected with a single compare.
+    struct TopK
+    {
+        explicit TopK(int k) : k(juce::jmax(0, k)) { heap.reserve((size_t) this->k); }
+
+        void push(float score, int index)
+        {
+            if ((int) heap.size() < k)
+            {
+                heap.push_back({ score, index });
+                std::push_heap(heap.begin(), heap.end(), weaker);
+            }
+            else if (k > 0 && score > heap.front().score)
+            {
+                std::pop_heap(heap.begin(), heap.end(), weaker);
+                heap.back() = { score, index };
+                std::push_heap(heap.begin(), heap.end(), weaker);
+            }
+        }
+
+        std::vector<Hit> sorted()
+        {
+            std::sort_heap(heap.begin(), heap.end(), weaker);
+            return std::move(heap);
+        }
+
+        static bool weaker(const Hit& a, const Hit& b) { return a.score > b.score; }
+
+        int k;
+        std::vector<Hit> heap;
+    };
+
+    std::unique_ptr<juce::MemoryMappedFile> mapped;
+    int numRows = 0;
+};
@@ -0,0 +1,297 @@
+#pragma once
+#include <JuceHeader.h>
+
+#if JUCE_MAC || JUCE_LINUX || JUCE_BSD
+ #include <sys/socket.h>
+ #include <sys/time.h>
+ #include <sys/un.h>
+ #include <unistd.h>
+ #include <cerrno>
+ #define SOUNDSIFT_HAS_IPC 1
+#else
+ #define SOUNDSIFT_HAS_IPC 0
+#endif
+
+// Client side of the backend's same-machine transport (Backend/src/ipc.py).
+// Control messages are length-prefixed JSON over a Unix domain socket;
+// result records, vectors and paths are read straight out of the slot of
+// the shared-memory file the server assigned this connection.
+//
+// One request at a time per connection, serialised by an internal lock,
+// so it can be shared between ApiClients and called from worker threads.
+class IpcTransport
+{
+public:
+    struct Record
+    {
+        float score;
+        float similarity;
+        juce::int32 id;
+        juce::uint16 library;
+        juce::uint16 pad;
+        juce::uint32 pathOffset;
+        juce::uint32 pathLength;
+        float offset;
+    };
+
+    static_assert(sizeof(Record) == 28, "Record must match ipc.py's RECORD_DTYPE");
+
+    ~IpcTransport() { disconnect(); }
+
+    bool connect(const juce::String& socketPath, const juce::String& sharedPath)
+    {
+        const juce::ScopedLock lock(requestLock);
+        disconnectLocked();
+
+       #if SOUNDSIFT_HAS_IPC
+        sockaddr_un address {};
+        address.sun_family = AF_UNIX;
+
+        if (socketPath.getNumBytesAsUTF8() >= sizeof(address.sun_path))
+            return false;
+
+        socketPath.copyToUTF8(address.sun_path, sizeof(address.sun_path));
+
+        fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0)
+            return false;
+
+        timeval timeout { 30, 0 };
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+       #ifdef SO_NOSIGPIPE
+        int one = 1;
+        ::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+       #endif
+
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+        {
+            disconnectLocked();
+            return false;
+        }
+
+        shared = std::make_unique<juce::MemoryMappedFile>(juce::File(sharedPath), juce::MemoryMappedFile::readOnly);
+        auto* data = static_cast<const char*>(shared->getData());
+
+        if (data == nullptr || shared->getSize() < fileHeaderBytes || std::memcmp(data, "SSSM", 4) != 0
+            || juce::ByteOrder::littleEndianInt(data + 4) != version)
+        {
+            disconnectLocked();
+            return false;
+        }
+
+        slotBytes = juce::ByteOrder::littleEndianInt(data + 12);
+        maxResults = (int) juce::ByteOrder::littleEndianInt(data + 16);
+        dim = (int) juce::ByteOrder::littleEndianInt(data + 20);
+
+        juce::var hello;
+        if (! roundTrip("{\"op\":\"hello\"}", hello) || ! (bool) hello["ok"])
+        {
+            disconnectLocked();
+            return false;
+        }
+
+        auto offset = (size_t) (juce::int64) hello["offset"];
+
+        if (offset + slotBytes > shared->getSize())
+        {
+            disconnectLocked();
+            return false;
+        }
+
+        slot = data + offset;
+        connected = true;
+        return true;
+       #else
+        juce::ignoreUnused(socketPath, sharedPath);
+        return false;
+       #endif
+    }
+
+    void disconnect()
+    {
+        const juce::ScopedLock lock(requestLock);
+        disconnectLocked();
+    }
+
+    bool isConnected() const { return connected.load(); }
+
+    enum class Outcome
+    {
+        answered,  // response holds the results
+        rejected,  // the server refused the request; response holds its "detail"
+        failed     // the transport broke: disconnect and use HTTP
+    };
+
+    // Runs a query whose args match the /query/text body. response is
+    // filled in the same shape the HTTP endpoint returns, so
+    // ApiClient::decodeResults works on it; serverTiming gets the stage
+    // timings in Server-Timing header form. vectors, if given, receives
+    // each result's embedding back to back.
+    Outcome query(const juce::String& argsJson, juce::var& response, juce::String& serverTiming,
+                  std::vector<float>* vectors = nullptr)
+    {
+        const juce::ScopedLock lock(requestLock);
+
+        juce::var reply;
+        if (! connected || ! roundTrip("{\"op\":\"query\",\"args\":" + argsJson + "}", reply) || ! reply.isObject())
+            return Outcome::failed;
+
+        // An error reply is an answer: the connection is still good
+        if (! (bool) reply["ok"])
+        {
+            juce::DynamicObject::Ptr body = new juce::DynamicObject();
+            body->setProperty("detail", reply["error"]);
+            response = juce::var(body.get());
+            return Outcome::rejected;
+        }
+
+        auto count = (int) juce::ByteOrder::littleEndianInt(slot);
+        if (count < 0 || count > maxResults)
+            return Outcome::failed;
+
+        auto* records = reinterpret_cast<const Record*>(slot + slotHeaderBytes);
+        auto* vectorData = reinterpret_cast<const float*>(slot + slotHeaderBytes + (size_t) maxResults * sizeof(Record));
+        auto* paths = reinterpret_cast<const char*>(vectorData) + (size_t) maxResults * (size_t) dim * sizeof(float);
+        auto pathBytes = slotBytes - (size_t) (paths - slot);
+        auto* libraries = reply["libraries"].getArray();
+
+        juce::Array<juce::var> results;
+        results.ensureStorageAllocated(count);
+
+        for (int i = 0; i < count; ++i)
+        {
+            auto& record = records[i];
+
+            if ((size_t) record.pathOffset + record.pathLength > pathBytes)
+                return Outcome::failed;
+
+            juce::DynamicObject::Ptr hit = new juce::DynamicObject();
+            hit->setProperty("library", libraries != nullptr ? (*libraries)[record.library] : juce::var());
+            hit->setProperty("id", (int) record.id);
+            hit->setProperty("score", record.score);
+            hit->setProperty("similarity", record.similarity);
+            hit->setProperty("offset", record.offset);
+            hit->setProperty("path", juce::String::fromUTF8(paths + record.pathOffset, (int) record.pathLength));
+            results.add(juce::var(hit.get()));
+        }
+
+        if (vectors != nullptr)
+            vectors->assign(vectorData, vectorData + (size_t) count * (size_t) dim);
+
+        juce::StringArray timings;
+        if (auto* stages = reply["timings"].getDynamicObject())
+            for (auto& stage : stages->getProperties())
+                timings.add(stage.name.toString() + ";dur=" + juce::String((double) stage.value, 3));
+        serverTiming = timings.joinIntoString(", ");
+
+        juce::DynamicObject::Ptr body = new juce::DynamicObject();
+        body->setProperty("results", results);
+        body->setProperty("index_version", reply["index_version"]);
+        response = juce::var(body.get());
+        return Outcome::answered;
+    }
+
+private:
+    static constexpr size_t fileHeaderBytes = 64;
+    static constexpr size_t slotHeaderBytes = 16;
+    static constexpr juce::uint32 version = 2;
+    static constexpr juce::uint32 maxMessageBytes = 16 * 1024 * 1024;
+
+    void disconnectLocked()
+    {
+       #if SOUNDSIFT_HAS_IPC
+        if (fd >= 0)
+            ::close(fd);
+       #endif
+
+        fd = -1;
+        shared.reset();
+        slot = nullptr;
+        connected = false;
+    }
+
+    bool roundTrip(const juce::String& message, juce::var& reply)
+    {
+        auto length = (juce::uint32) message.getNumBytesAsUTF8();
+        auto header = juce::ByteOrder::swapIfBigEndian(length);
+
+        if (! writeAll(&header, sizeof(header)) || ! writeAll(message.toRawUTF8(), length))
+            return false;
+
+        if (! readAll(&header, sizeof(header)))
+            return false;
+
+        header = juce::ByteOrder::swapIfBigEndian(header);
+        if (header > maxMessageBytes)
+            return false;
+
+        juce::MemoryBlock body(header);
+        if (! readAll(body.getData(), body.getSize()))
+            return false;
+
+        return juce::JSON::parse(body.toString(), reply).wasOk();
+    }
+
+    bool writeAll(const void* data, size_t size)
+    {
+       #if SOUNDSIFT_HAS_IPC
+        auto* bytes = static_cast<const char*>(data);
+
+        while (size > 0)
+        {
+           #ifdef MSG_NOSIGNAL
+            auto sent = ::send(fd, bytes, size, MSG_NOSIGNAL);
+           #else
+            auto sent = ::send(fd, bytes, size, 0);
+           #endif
+
+            if (sent < 0 && errno == EINTR)
+                continue;
+            if (sent <= 0)
+                return false;
+
+            bytes += sent;
+            size -= (size_t) sent;
+        }
+
+        return true;
+       #else
+        juce::ignoreUnused(data, size);
+        return false;
+       #endif
+    }
+
+    bool readAll(void* data, size_t size)
+    {
+       #if SOUNDSIFT_HAS_IPC
+        auto* bytes = static_cast<char*>(data);
+
+        while (size > 0)
+        {
+            auto received = ::recv(fd, bytes, size, 0);
+
+            if (received < 0 && errno == EINTR)
+                continue;
+            if (received <= 0)
+                return false;
+
+            bytes += received;
+            size -= (size_t) received;
+        }
+
+        return true;
+       #else
+        juce::ignoreUnused(data, size);
+        return false;
+       #endif
+    }
+
+    std::unique_ptr<juce::MemoryMappedFile> shared;
+    const char* slot = nullptr;
+    size_t slotBytes = 0;
+    int maxResults = 0;
+    int dim = 0;
+    int fd = -1;
+    std::atomic<bool> connected { false };
+    juce::CriticalSection requestLock;
+};
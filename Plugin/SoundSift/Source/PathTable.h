@@ -0,0 +1,82 @@
+#pragma once
+#include <JuceHeader.h>
+
+// Read-only view of the paths.bin sidecar the backend writes next to
+// embeddings.bin, mapping vec_index -> file path without a catalog query.
+//
+// Layout (little endian):
+//   char[4]  "SSPT"
+//   uint32   count
+//   uint64   offsets[count + 1]   byte offsets into the string blob
+//   char[]   UTF-8 string blob
+class PathTable
+{
+public:
+    PathTable() = default;
+    explicit PathTable(const juce::File& file) { open(file); }
+
+    bool open(const juce::File& file)
+    {
+        count = 0;
+        offsets = nullptr;
+        blob = nullptr;
+        mapped = std::make_unique<juce::MemoryMappedFile>(file, juce::MemoryMappedFile::readOnly);
+
+        auto* data = static_cast<const char*>(mapped->getData());
+        auto size = mapped->getSize();
+
+        if (data == nullptr || size < headerBytes || std::memcmp(data, "SSPT", 4) != 0)
+        {
+            mapped.reset();
+            return false;
+        }
+
+        auto n = (size_t) juce::ByteOrder::littleEndianInt(data + 4);
+        auto tableEnd = headerBytes + (n + 1) * sizeof(juce::uint64);
+
+        if (tableEnd > size)
+        {
+            mapped.reset();
+            return false;
+        }
+
+        offsets = reinterpret_cast<const juce::uint64*>(data + headerBytes);
+        blob = data + tableEnd;
+        blobSize = size - tableEnd;
+
+        if (offsets[n] > blobSize)
+        {
+            mapped.reset();
+            return false;
+        }
+
+        count = (int) n;
+        return true;
+    }
+
+    bool isOpen() const { return mapped != nullptr; }
+    int size() const { return count; }
+
+    juce::String operator[](int index) const
+    {
+        if (index < 0 || index >= count)
+            return {};
+
+        auto start = offsets[index];
+        auto end = offsets[index + 1];
+
+        if (end < start || end > blobSize)
+            return {};
+
+        return juce::String::fromUTF8(blob + start, (int) (end - start));
+    }
+
+private:
+    static constexpr size_t headerBytes = 8;
+
+    std::unique_ptr<juce::MemoryMappedFile> mapped;
+    const juce::uint64* offsets = nullptr;
+    const char* blob = nullptr;
+    size_t blobSize = 0;
+    int count = 0;
+};
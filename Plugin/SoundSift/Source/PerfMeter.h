@@ -0,0 +1,67 @@
+#pragma once
+#include <JuceHeader.h>
+#include "AudioPerfMonitor.h"
+
+// CPU and xrun meter for the status row. Polls the processor's
+// AudioPerfMonitor on a timer: the bar is the smoothed load against the
+// block deadline, the tick the peak since the last poll, and the counters
+// (blocks over deadline, disk underruns and starved kit notes together)
+// turn red once anything has gone wrong. Clicking it calls onClick.
+class PerfMeter : public juce::Component,
+                  private juce::Timer
+{
+public:
+    explicit PerfMeter(AudioPerfMonitor& m) : monitor(m)
+    {
+        startTimerHz(refreshHz);
+    }
+
+    std::function<void()> onClick;
+
+    void paint(juce::Graphics& g) override
+    {
+        auto area = getLocalBounds().reduced(2);
+        auto bar = area.removeFromLeft(area.getWidth() / 3).reduced(0, 6).toFloat();
+
+        g.setColour(juce::Colours::darkgrey);
+        g.fillRect(bar);
+
+        auto load = juce::jlimit(0.0f, 1.0f, stats.averageLoad);
+        g.setColour(stats.averageLoad < 0.5f ? juce::Colours::limegreen
+                    : stats.averageLoad < 0.8f ? juce::Colours::orange : juce::Colours::red);
+        g.fillRect(bar.withWidth(bar.getWidth() * load));
+
+        g.setColour(juce::Colours::white);
+        auto peakX = bar.getX() + bar.getWidth() * juce::jlimit(0.0f, 1.0f, peak);
+        g.drawVerticalLine((int) peakX, bar.getY(), bar.getBottom());
+
+        auto problems = stats.overruns + stats.diskUnderruns + stats.starvedNotes;
+        g.setColour(problems > 0 ? juce::Colours::red : juce::Colours::white);
+        g.setFont(12.0f);
+        g.drawText(juce::String(juce::roundToInt(stats.averageLoad * 100.0f)) + "%  xruns "
+                       + juce::String((juce::int64) problems),
+                   area.withTrimmedLeft(4), juce::Justification::centredLeft, true);
+    }
+
+    void mouseUp(const juce::MouseEvent& e) override
+    {
+        if (onClick != nullptr && getLocalBounds().contains(e.getPosition()))
+            onClick();
+    }
+
+private:
+    static constexpr int refreshHz = 10;
+
+    void timerCallback() override
+    {
+        stats = monitor.getStats();
+        peak = monitor.takePeakLoad();
+        repaint();
+    }
+
+    AudioPerfMonitor& monitor;
+    AudioPerfMonitor::Stats stats;
+    float peak = 0.0f;
+
+    JUCE_DECLARE_NON_COPYABLE(PerfMeter)
+};
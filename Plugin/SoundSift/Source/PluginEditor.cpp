@@ -1,10 +1,93 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 
+// Pulls filter tokens out of the query text and returns them as a
+// QueryFilters object, e.g. "snare dur<1 in:Drums ext:wav after:2026-01-01
+// bpm:118-122 lufs>-14 sort:-bpm tag:snare". Whatever isn't a filter token
+// is left in query.
+static juce::var extractSearchFilters(juce::String& query)
+{
+    juce::StringArray tokens;
+    tokens.addTokens(query, " ", "\"");
+    
+    juce::DynamicObject::Ptr filters = new juce::DynamicObject();
+    juce::DynamicObject::Ptr descriptors = new juce::DynamicObject();
+    juce::Array<juce::var> tags;
+    juce::StringArray words;
+    
+    // Narrows [lo, hi] of a descriptor range, either end open (void)
+    auto setBound = [&descriptors](const juce::String& column, int end, double value)
+    {
+        juce::Array<juce::var> range { juce::var(), juce::var() };
+        if (auto* existing = descriptors->getProperty(column).getArray())
+            range = *existing;
+        range.set(end, value);
+        descriptors->setProperty(column, range);
+    };
+    
+    for (auto token : tokens)
+    {
+        token = token.unquoted();
+        
+        if (token.startsWith("dur<"))
+            filters->setProperty("max_duration", token.fromFirstOccurrenceOf("<", false, false).getDoubleValue());
+        else if (token.startsWith("dur>"))
+            filters->setProperty("min_duration", token.fromFirstOccurrenceOf(">", false, false).getDoubleValue());
+        else if (token.startsWith("in:"))
+            filters->setProperty("folder", token.fromFirstOccurrenceOf(":", false, false));
+        else if (token.startsWith("ext:"))
+        {
+            juce::Array<juce::var> exts;
+            for (auto& ext : juce::StringArray::fromTokens(token.fromFirstOccurrenceOf(":", false, false), ",", ""))
+                exts.add(ext);
+            filters->setProperty("extensions", exts);
+        }
+        else if (token.startsWith("after:"))
+            filters->setProperty("indexed_after", token.fromFirstOccurrenceOf(":", false, false));
+        else if (token.startsWith("bpm:"))
+        {
+            // "bpm:120" allows +-2 BPM, "bpm:118-122" is an explicit range
+            auto value = token.fromFirstOccurrenceOf(":", false, false);
+            auto lo = value.upToFirstOccurrenceOf("-", false, false).getDoubleValue();
+            auto hi = value.containsChar('-') ? value.fromFirstOccurrenceOf("-", false, false).getDoubleValue() : lo;
+            setBound("bpm", 0, value.containsChar('-') ? lo : lo - 2.0);
+            setBound("bpm", 1, value.containsChar('-') ? hi : hi + 2.0);
+        }
+        else if (token.startsWith("lufs<"))
+            setBound("lufs", 1, token.fromFirstOccurrenceOf("<", false, false).getDoubleValue());
+        else if (token.startsWith("lufs>"))
+            setBound("lufs", 0, token.fromFirstOccurrenceOf(">", false, false).getDoubleValue());
+        else if (token.startsWith("sort:"))
+            filters->setProperty("sort_by", token.fromFirstOccurrenceOf(":", false, false));
+        else if (token.startsWith("tag:"))
+        {
+            // "tag:snare" or "tag:vocal,riser": precomputed zero-shot tags, all must match
+            for (auto& tag : juce::StringArray::fromTokens(token.fromFirstOccurrenceOf(":", false, false), ",", ""))
+                tags.add(tag.toLowerCase());
+        }
+        else if (token.isNotEmpty())
+            words.add(token);
+    }
+    
+    query = words.joinIntoString(" ");
+    
+    if (! descriptors->getProperties().isEmpty())
+        filters->setProperty("descriptors", juce::var(descriptors.get()));
+    
+    if (! tags.isEmpty())
+        filters->setProperty("tags", tags);
+    
+    if (filters->getProperties().isEmpty())
+        return {};
+    
+    return juce::var(filters.get());
+}
+
 SoundSiftAudioProcessorEditor::SoundSiftAudioProcessorEditor (SoundSiftAudioProcessor& p)
     : AudioProcessorEditor (&p),
       audioProcessor (p),
-      audioPlayer (p)  // <--- CRITICAL FIX: Pass the processor to the player here
+      audioPlayer (p),  // <--- CRITICAL FIX: Pass the processor to the player here
+      perfMeter (p.getPerfMonitor())
 {
     // Embed button (now "Index Folder")
     addAndMakeVisible(embedButton);
@@ -17,6 +100,8 @@ SoundSiftAudioProcessorEditor::SoundSiftAudioProcessorEditor (SoundSiftAudioProc
     searchBox.setMultiLine(false);
     searchBox.setReturnKeyStartsNewLine(false);
     searchBox.onReturnKey = [this] { searchButtonClicked(); };
+    searchBox.onTextChange = [this] { searchTextChanged(); };
+    searchBox.onEscapeKey = [this] { suggestionsList.setVisible(false); };
     
     // Search button
     addAndMakeVisible(searchButton);
@@ -28,7 +113,13 @@ SoundSiftAudioProcessorEditor::SoundSiftAudioProcessorEditor (SoundSiftAudioProc
     topKSlider.setRange(1, 50, 1);
     topKSlider.setValue(10);
     topKSlider.setTextBoxStyle(juce::Slider::TextBoxRight, false, 50, 20);
-    topKSlider.onValueChange = [this] { topK = (int)topKSlider.getValue(); };
+    topKSlider.onValueChange = [this]
+    {
+        topK = (int)topKSlider.getValue();
+        auto session = audioProcessor.getSession();
+        session.topK = topK;
+        audioProcessor.setSession(session);
+    };
     
     addAndMakeVisible(topKLabel);
     topKLabel.setText("Results:", juce::dontSendNotification);
@@ -40,6 +131,14 @@ SoundSiftAudioProcessorEditor::SoundSiftAudioProcessorEditor (SoundSiftAudioProc
     resultsList.setModel(resultsModel.get());
     resultsList.setRowHeight(30);
     
+    // Type-ahead dropdown, overlaid on the results list while typing
+    addChildComponent(suggestionsList);
+    suggestionsModel = std::make_unique<SuggestionsListBoxModel>(*this);
+    suggestionsList.setModel(suggestionsModel.get());
+    suggestionsList.setRowHeight(24);
+    suggestionsList.setOutlineThickness(1);
+    suggestionsList.setMouseClickGrabsKeyboardFocus(false);
+    
     // Audio player
     addAndMakeVisible(audioPlayer);
     
@@ -47,18 +146,83 @@ SoundSiftAudioProcessorEditor::SoundSiftAudioProcessorEditor (SoundSiftAudioProc
     addAndMakeVisible(statusLabel);
     statusLabel.setText("Ready - Click 'Index Folder' to begin", juce::dontSendNotification);
     
+    // Search tracing
+    apiClient.setTrace(searchTrace);
+    apiClient.setWorkers(&audioProcessor.core->workers);
+    apiClient.setIpc(audioProcessor.core->ipc);
+    addAndMakeVisible(traceButton);
+    traceButton.setButtonText("Export Trace");
+    traceButton.onClick = [this] { traceButtonClicked(); };
+    
+    addAndMakeVisible(kitButton);
+    kitButton.setButtonText("Load Kit");
+    kitButton.onClick = [this] { kitButtonClicked(); };
+    
+    // In-process semantic search, when the backend exported a text encoder
+    addAndMakeVisible(localButton);
+    localButton.setButtonText("Local");
+    localButton.onClick = [this]
+    {
+        auto session = audioProcessor.getSession();
+        session.localSearch = localButton.getToggleState();
+        audioProcessor.setSession(session);
+    };
+    
+    // Audio thread load and xruns; click to save the full report
+    addAndMakeVisible(perfMeter);
+    perfMeter.onClick = [this] { perfMeterClicked(); };
+    
     // --- REMOVED: audioProcessor.setAudioPlayer(&audioPlayer); ---
     // The player now controls the processor directly via the reference passed in the initializer list.
     
     setSize(600, 550);
+    
+    restoreSession();
+    refreshStatus();
+    
+    audioProcessor.addChangeListener(this);
+    if (audioProcessor.getReadiness() != SoundSiftAudioProcessor::Readiness::ready)
+        showReadiness();
 }
 
 SoundSiftAudioProcessorEditor::~SoundSiftAudioProcessorEditor()
 {
+    audioProcessor.removeChangeListener(this);
+    
     // --- REMOVED: audioProcessor.setAudioPlayer(nullptr); ---
     // No longer needed.
 }
 
+void SoundSiftAudioProcessorEditor::changeListenerCallback(juce::ChangeBroadcaster*)
+{
+    showReadiness();
+    
+    // Suggestions and the restored session's index check may have missed
+    // the server while it was down
+    if (audioProcessor.getReadiness() == SoundSiftAudioProcessor::Readiness::ready)
+        refreshStatus();
+}
+
+void SoundSiftAudioProcessorEditor::showReadiness()
+{
+    switch (audioProcessor.getReadiness())
+    {
+        case SoundSiftAudioProcessor::Readiness::connecting:
+            statusLabel.setText("Connecting to SoundSift server...", juce::dontSendNotification);
+            break;
+        case SoundSiftAudioProcessor::Readiness::warming:
+            statusLabel.setText("Warming up search index...", juce::dontSendNotification);
+            break;
+        case SoundSiftAudioProcessor::Readiness::offline:
+            statusLabel.setText("Server offline - start the backend (retrying...)", juce::dontSendNotification);
+            break;
+        case SoundSiftAudioProcessor::Readiness::ready:
+            statusLabel.setText(searchResults.isEmpty() ? "Ready - Click 'Index Folder' to begin" : "Ready",
+                                 juce::dontSendNotification);
+            break;
+    }
+}
+
 void SoundSiftAudioProcessorEditor::paint (juce::Graphics& g)
 {
     g.fillAll(getLookAndFeel().findColour(juce::ResizableWindow::backgroundColourId));
@@ -83,6 +247,9 @@ void SoundSiftAudioProcessorEditor::resized()
     searchBox.setBounds(searchArea.reduced(2));
     area.removeFromTop(10);
     
+    suggestionsList.setBounds(searchBox.getX(), searchBox.getBottom(), searchBox.getWidth(),
+                              maxSuggestions * suggestionsList.getRowHeight() + 2);
+    
     // Results list
     resultsList.setBounds(area.removeFromTop(200).reduced(2));
     area.removeFromTop(10);
@@ -92,7 +259,12 @@ void SoundSiftAudioProcessorEditor::resized()
     area.removeFromTop(10);
     
     // Status label
-    statusLabel.setBounds(area.removeFromTop(30).reduced(2));
+    auto statusArea = area.removeFromTop(30);
+    traceButton.setBounds(statusArea.removeFromRight(100).reduced(2));
+    kitButton.setBounds(statusArea.removeFromRight(100).reduced(2));
+    localButton.setBounds(statusArea.removeFromRight(70).reduced(2));
+    perfMeter.setBounds(statusArea.removeFromRight(130).reduced(2));
+    statusLabel.setBounds(statusArea.reduced(2));
 }
 
 void SoundSiftAudioProcessorEditor::embedButtonClicked()
@@ -117,91 +289,309 @@ void SoundSiftAudioProcessorEditor::embedButtonClicked()
         statusLabel.setText("Indexing folder: " + directory.getFileName() + "...",
                              juce::dontSendNotification);
         
-        apiClient.indexFolder(folderPath,
+        apiClient.indexFolder(folderPath, whileOpen(
             [this](bool success, juce::var response)
             {
-                juce::MessageManager::callAsync([this, success, response]()
+                // ApiClient already calls back on the message thread
+                if (success && response.hasProperty("status"))
                 {
-                    if (success && response.hasProperty("status"))
+                    auto status = response["status"].toString();
+                    if (status == "ok")
                     {
-                        auto status = response["status"].toString();
-                        if (status == "ok")
-                        {
-                            int filesEmbedded = response.getProperty("files_embedded", 0);
-                            statusLabel.setText("Indexed " + juce::String(filesEmbedded) + " files!",
-                                                 juce::dontSendNotification);
-                        }
-                        else
-                        {
-                            statusLabel.setText("Indexing failed", juce::dontSendNotification);
-                        }
+                        int filesEmbedded = response.getProperty("files_embedded", 0);
+                        statusLabel.setText("Indexed " + juce::String(filesEmbedded) + " files!",
+                                             juce::dontSendNotification);
+                        refreshStatus();
                     }
                     else
                     {
-                        statusLabel.setText("Indexing request failed", juce::dontSendNotification);
+                        statusLabel.setText("Indexing failed", juce::dontSendNotification);
                     }
-                });
-            }
+                }
+                else
+                {
+                    statusLabel.setText("Indexing request failed", juce::dontSendNotification);
+                }
+            })
         );
     });
 }
 
+void SoundSiftAudioProcessorEditor::refreshStatus()
+{
+    apiClient.getStatus(whileOpen([this](bool success, juce::var response)
+    {
+        if (! success)
+            return;
+        
+        auto indexVersion = response["index_version"].toString();
+        audioProcessor.core->connectIpc(response["ipc"]);
+        audioProcessor.core->openTextEncoder(response["text_encoder"]);
+        
+        if (response.hasProperty("data_dir"))
+        {
+            audioProcessor.core->openIndex(juce::File(response["data_dir"].toString()),
+                                           juce::File(response["suggestions"].toString()),
+                                           indexVersion, response["stores"]);
+            audioProcessor.core->saveStatus(response);
+        }
+        
+        // Restored results stay on screen; they're only re-fetched once the
+        // index they came from has changed
+        auto session = audioProcessor.getSession();
+        
+        if (session.query.isNotEmpty() && indexVersion.isNotEmpty() && indexVersion != session.indexVersion)
+            runSearch(session.query, true);
+    }));
+}
+
+void SoundSiftAudioProcessorEditor::restoreSession()
+{
+    auto session = audioProcessor.getSession();
+    
+    searchBox.setText(session.query, false);
+    topKSlider.setValue(session.topK);
+    localButton.setToggleState(session.localSearch, juce::dontSendNotification);
+    
+    searchResults.clear();
+    searchOffsets.clear();
+    for (auto& result : session.results)
+    {
+        searchResults.add(result.path);
+        searchOffsets.add(result.offset);
+    }
+    
+    resultsList.updateContent();
+    
+    if (session.selectedRow >= 0)
+    {
+        resultsList.selectRow(session.selectedRow);
+        statusLabel.setText("Loaded: " + juce::File(searchResults[session.selectedRow]).getFileName(),
+                             juce::dontSendNotification);
+    }
+    else if (! searchResults.isEmpty())
+    {
+        statusLabel.setText("Restored " + juce::String(searchResults.size()) + " results",
+                             juce::dontSendNotification);
+    }
+}
+
+void SoundSiftAudioProcessorEditor::saveSelection(int row)
+{
+    auto session = audioProcessor.getSession();
+    session.selectedRow = row;
+    audioProcessor.setSession(session);
+}
+
+void SoundSiftAudioProcessorEditor::searchTextChanged()
+{
+    suggestions.clear();
+    suggestionWords.clear();
+    
+    auto text = searchBox.getText();
+    auto words = juce::StringArray::fromTokens(text, " ", "\"");
+    words.removeEmptyStrings();
+    
+    auto completing = ! words.isEmpty() && ! text.endsWithChar(' ')
+                   && ! words[words.size() - 1].containsAnyOf(":<>");
+    
+    if (completing)
+    {
+        auto last = words[words.size() - 1];
+        
+        // Phrase completions ("war d" -> "war drum") first, then single words
+        if (words.size() >= 2)
+        {
+            for (auto& phrase : audioProcessor.core->complete(words[words.size() - 2] + " " + last, maxSuggestions))
+            {
+                suggestions.add(phrase);
+                suggestionWords.add(2);
+            }
+        }
+        
+        for (auto& word : audioProcessor.core->complete(last, maxSuggestions))
+        {
+            if (suggestions.size() >= maxSuggestions)
+                break;
+            
+            if (! suggestions.contains(word))
+            {
+                suggestions.add(word);
+                suggestionWords.add(1);
+            }
+        }
+    }
+    
+    suggestionsList.updateContent();
+    suggestionsList.deselectAllRows();
+    suggestionsList.setVisible(! suggestions.isEmpty());
+    suggestionsList.toFront(false);
+}
+
+void SoundSiftAudioProcessorEditor::suggestionClicked(int index)
+{
+    if (index < 0 || index >= suggestions.size())
+        return;
+    
+    auto words = juce::StringArray::fromTokens(searchBox.getText(), " ", "\"");
+    words.removeEmptyStrings();
+    words.removeRange(words.size() - suggestionWords[index], suggestionWords[index]);
+    words.add(suggestions[index]);
+    
+    searchBox.setText(words.joinIntoString(" "), false);
+    searchBox.grabKeyboardFocus();
+    searchButtonClicked();
+}
+
 void SoundSiftAudioProcessorEditor::searchButtonClicked()
 {
-    auto query = searchBox.getText();
+    suggestionsList.setVisible(false);
+    runSearch(searchBox.getText(), false);
+}
+
+// refresh re-runs a restored query in the background: the current results
+// stay up until the new ones arrive and the selection follows its path
+void SoundSiftAudioProcessorEditor::runSearch(const juce::String& text, bool refresh)
+{
+    auto query = text;
+    auto filters = extractSearchFilters(query);
     
-    if (query.isEmpty())
+    // A bare "tag:snare" browses the samples scoring best for the tag
+    auto browsing = query.isEmpty() && filters["tags"].size() > 0;
+    
+    if (query.isEmpty() && ! browsing)
     {
-        statusLabel.setText("Please enter a search query", juce::dontSendNotification);
+        if (! refresh)
+            statusLabel.setText("Please enter a search query", juce::dontSendNotification);
         return;
     }
     
-    statusLabel.setText("Searching for: " + query + "...", juce::dontSendNotification);
+    if (! refresh)
+        statusLabel.setText("Searching for: " + text + "...", juce::dontSendNotification);
+    
+    // With "Local" on, plain queries are encoded and scanned in process
+    // once the exported text encoder is loaded. That is semantic ranking
+    // only, so it is opt-in, and filtered queries still need the server.
+    auto local = localButton.getToggleState() && filters.isVoid() && audioProcessor.core->canSearchLocally();
+    
+    // Another instance may already have run this exact search. Local and
+    // server results rank differently, so they are cached apart.
+    auto cacheKey = text + "|" + juce::String(topK);
+    auto localKey = cacheKey + "|local";
+    juce::var cached;
+    
+    if (! refresh && audioProcessor.core->findResults(local ? localKey : cacheKey, cached))
+    {
+        showResults(text, cached, refresh);
+        return;
+    }
     
-    apiClient.queryText(query, topK,
-        [this](bool success, juce::var response)
+    if (local)
+    {
+        auto* core = &audioProcessor.core.getObject();
+        auto trace = searchTrace;
+        auto k = topK;
+        juce::Component::SafePointer<SoundSiftAudioProcessorEditor> editor(this);
+        
+        core->workers.addJob([core, trace, editor, query, text, refresh, cacheKey, localKey, k]
         {
-            juce::MessageManager::callAsync([this, success, response]()
+            auto response = core->searchLocal(query, k, trace.get());
+            
+            juce::MessageManager::callAsync([editor, query, text, refresh, cacheKey, localKey, response]
             {
-                if (success && response.hasProperty("results"))
+                if (editor == nullptr)
+                    return;
+                
+                if (response["results"].isArray())
                 {
-                    searchResults.clear();
-                    auto results = response["results"];
-                   
-                    if (results.isArray())
-                    {
-                        auto* array = results.getArray();
-                       
-                        for (auto& item : *array)
-                        {
-                            // Your API returns results as objects with 'path' and 'similarity'
-                            if (item.isObject() && item.hasProperty("path"))
-                            {
-                                searchResults.add(item["path"].toString());
-                            }
-                            // Or if it returns just strings
-                            else if (item.isString())
-                            {
-                                searchResults.add(item.toString());
-                            }
-                        }
-                       
-                        resultsList.updateContent();
-                        statusLabel.setText("Found " + juce::String(searchResults.size()) + " results",
-                                             juce::dontSendNotification);
-                    }
-                    else
-                    {
-                        statusLabel.setText("No results found", juce::dontSendNotification);
-                    }
+                    editor->audioProcessor.core->addResults(localKey, response);
+                    editor->showResults(text, response, refresh);
                 }
                 else
                 {
-                    statusLabel.setText("Search failed - is the index loaded?", juce::dontSendNotification);
+                    // No encoder, or the index moved on under the mapping:
+                    // the server's answer also brings the remap
+                    editor->queryServer(query, {}, text, refresh, cacheKey);
                 }
             });
+        });
+        return;
+    }
+    
+    queryServer(query, filters, text, refresh, cacheKey);
+}
+
+void SoundSiftAudioProcessorEditor::queryServer(const juce::String& query, const juce::var& filters,
+                                                const juce::String& text, bool refresh, const juce::String& cacheKey)
+{
+    auto handleResponse = whileOpen([this, text, refresh, cacheKey](bool success, juce::var response)
+    {
+        if (success && response["results"].isArray())
+        {
+            // Answered from a newer index than the one mapped: the cache
+            // was just dropped, and /status remaps the sidecars
+            if (! audioProcessor.core->addResults(cacheKey, response))
+                refreshStatus();
+            
+            showResults(text, response, refresh);
+        }
+        else if (success && response.hasProperty("results"))
+        {
+            if (! refresh)
+                statusLabel.setText("No results found", juce::dontSendNotification);
+        }
+        else if (! refresh && response["detail"].isString())
+        {
+            // Rejected by the server, e.g. an unknown tag: name
+            statusLabel.setText("Search failed - " + response["detail"].toString(), juce::dontSendNotification);
+        }
+        else if (! refresh)
+        {
+            statusLabel.setText("Search failed - is the index loaded?", juce::dontSendNotification);
         }
-    );
+    });
+    
+    if (query.isEmpty())
+        apiClient.topTagged(filters["tags"][0].toString(), topK, filters, handleResponse);
+    else
+        apiClient.queryText(query, topK, filters, handleResponse);
+}
+
+void SoundSiftAudioProcessorEditor::showResults(const juce::String& text, const juce::var& response, bool refresh)
+{
+    auto session = audioProcessor.getSession();
+    auto selectedPath = refresh ? searchResults[session.selectedRow] : juce::String();
+    
+    session.query = text;
+    session.topK = topK;
+    session.results = ApiClient::decodeResults(response);
+    session.indexVersion = response["index_version"].toString();
+    session.selectedRow = -1;
+    
+    searchResults.clear();
+    searchOffsets.clear();
+    for (auto& result : session.results)
+    {
+        searchResults.add(result.path);
+        searchOffsets.add(result.offset);
+    }
+    
+    if (selectedPath.isNotEmpty())
+        session.selectedRow = searchResults.indexOf(selectedPath);
+    
+    audioProcessor.setSession(session);
+    
+    resultsList.updateContent();
+    if (session.selectedRow >= 0)
+        resultsList.selectRow(session.selectedRow);
+    else
+        resultsList.deselectAllRows();
+    
+    auto latency = searchTrace->latencySummary();
+    statusLabel.setText((refresh ? "Index changed, refreshed " : "Found ")
+                            + juce::String(searchResults.size()) + " results"
+                            + (latency.isNotEmpty() ? " (" + latency + ")" : juce::String()),
+                         juce::dontSendNotification);
 }
 
 void SoundSiftAudioProcessorEditor::resultItemClicked(int index)
@@ -212,11 +602,17 @@ void SoundSiftAudioProcessorEditor::resultItemClicked(int index)
     if (index >= 0 && index < searchResults.size())
     {
         juce::File audioFile(searchResults[index]);
+        auto session = audioProcessor.getSession();
         
         if (audioFile.existsAsFile())
         {
-            // This now calls AudioPlayer::loadFile -> Processor::loadFile
-            audioPlayer.loadFile(audioFile);
+            // Session results carry library and id, which let the preview
+            // skip leading silence and level the sample from its descriptors
+            if (index < session.results.size())
+                audioPlayer.loadResult(session.results.getReference(index));
+            else
+                audioPlayer.loadFile(audioFile);
+            saveSelection(index);
             statusLabel.setText("Loaded: " + audioFile.getFileName(), juce::dontSendNotification);
         }
         else
@@ -225,3 +621,71 @@ void SoundSiftAudioProcessorEditor::resultItemClicked(int index)
         }
     }
 }
+
+void SoundSiftAudioProcessorEditor::kitButtonClicked()
+{
+    auto session = audioProcessor.getSession();
+    
+    if (session.results.isEmpty())
+    {
+        statusLabel.setText("Search first, then load the results as a kit", juce::dontSendNotification);
+        return;
+    }
+    
+    audioProcessor.loadKit(session.results);
+    
+    auto count = juce::jmin(session.results.size(), PreviewSampler::maxSlots);
+    statusLabel.setText("Kit: " + juce::String(count) + " results on MIDI notes "
+                            + juce::MidiMessage::getMidiNoteName(PreviewSampler::baseNote, true, true, 3) + " to "
+                            + juce::MidiMessage::getMidiNoteName(PreviewSampler::baseNote + count - 1, true, true, 3),
+                         juce::dontSendNotification);
+}
+
+void SoundSiftAudioProcessorEditor::traceButtonClicked()
+{
+    fileChooser = std::make_unique<juce::FileChooser>("Export search trace",
+                                                       juce::File::getSpecialLocation(juce::File::userDesktopDirectory)
+                                                           .getChildFile("soundsift_trace.json"),
+                                                       "*.json",
+                                                       true);
+    
+    fileChooser->launchAsync(juce::FileBrowserComponent::saveMode
+                               | juce::FileBrowserComponent::warnAboutOverwriting,
+                             [this](const juce::FileChooser& fc)
+    {
+        auto file = fc.getResult();
+        
+        if (file == juce::File())
+            return;
+        
+        if (searchTrace->exportChromeTrace(file))
+            statusLabel.setText("Trace saved: " + file.getFileName() + " (open in ui.perfetto.dev)",
+                                 juce::dontSendNotification);
+        else
+            statusLabel.setText("Could not write " + file.getFileName(), juce::dontSendNotification);
+    });
+}
+
+void SoundSiftAudioProcessorEditor::perfMeterClicked()
+{
+    fileChooser = std::make_unique<juce::FileChooser>("Save audio performance report",
+                                                       juce::File::getSpecialLocation(juce::File::userDesktopDirectory)
+                                                           .getChildFile("soundsift_perf.json"),
+                                                       "*.json",
+                                                       true);
+    
+    fileChooser->launchAsync(juce::FileBrowserComponent::saveMode
+                               | juce::FileBrowserComponent::warnAboutOverwriting,
+                             [this](const juce::FileChooser& fc)
+    {
+        auto file = fc.getResult();
+        
+        if (file == juce::File())
+            return;
+        
+        if (audioProcessor.getPerfMonitor().writeReport(file))
+            statusLabel.setText("Performance report saved: " + file.getFileName(), juce::dontSendNotification);
+        else
+            statusLabel.setText("Could not write " + file.getFileName(), juce::dontSendNotification);
+    });
+}
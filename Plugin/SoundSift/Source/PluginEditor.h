@@ -3,8 +3,10 @@
 #include "PluginProcessor.h"
 #include "ApiClient.h"
 #include "AudioPlayer.h"
+#include "PerfMeter.h"
 
-class SoundSiftAudioProcessorEditor : public juce::AudioProcessorEditor
+class SoundSiftAudioProcessorEditor : public juce::AudioProcessorEditor,
+                                      private juce::ChangeListener
 {
 public:
     SoundSiftAudioProcessorEditor (SoundSiftAudioProcessor&);
@@ -14,10 +16,37 @@ public:
     void resized() override;
 
 private:
+    void changeListenerCallback(juce::ChangeBroadcaster* source) override;
+    void showReadiness();
+    
     void embedButtonClicked();
     void searchTextChanged();
     void searchButtonClicked();
+    void runSearch(const juce::String& text, bool refresh);
+    void queryServer(const juce::String& query, const juce::var& filters,
+                     const juce::String& text, bool refresh, const juce::String& cacheKey);
+    void showResults(const juce::String& text, const juce::var& response, bool refresh);
     void resultItemClicked(int index);
+    void traceButtonClicked();
+    void kitButtonClicked();
+    void perfMeterClicked();
+    void refreshStatus();
+    void restoreSession();
+    void saveSelection(int row);
+    void suggestionClicked(int index);
+    
+    // ApiClient requests run on the SharedCore workers, which outlive this
+    // editor: a response arriving after the window closed is dropped
+    std::function<void(bool, juce::var)> whileOpen(std::function<void(bool, juce::var)> callback)
+    {
+        juce::Component::SafePointer<SoundSiftAudioProcessorEditor> editor(this);
+        
+        return [editor, callback](bool success, juce::var response)
+        {
+            if (editor != nullptr)
+                callback(success, response);
+        };
+    }
     
     SoundSiftAudioProcessor& audioProcessor;
     
@@ -26,15 +55,27 @@ private:
     juce::TextEditor searchBox;
     juce::TextButton searchButton;
     juce::ListBox resultsList;
+    juce::ListBox suggestionsList;
     AudioPlayer audioPlayer;
     juce::Label statusLabel;
+    juce::TextButton traceButton;
+    juce::TextButton kitButton;
+    juce::ToggleButton localButton;
+    PerfMeter perfMeter;
     
     // API Client
     ApiClient apiClient;
+    std::shared_ptr<SearchTrace> searchTrace = std::make_shared<SearchTrace>();
     
     // Search results
     juce::StringArray searchResults;
+    juce::Array<float> searchOffsets;  // start of each result's best matching window, seconds
     int topK = 10;  // Number of results to return
+    
+    // Type-ahead, answered locally from the backend's suggest.bin
+    juce::StringArray suggestions;
+    juce::Array<int> suggestionWords;  // trailing query words each suggestion replaces
+    static constexpr int maxSuggestions = 6;
     juce::Slider topKSlider;
     juce::Label topKLabel;
     
@@ -62,7 +103,14 @@ private:
             if (rowNumber < owner.searchResults.size())
             {
                 juce::File file(owner.searchResults[rowNumber]);
-                g.drawText(file.getFileName(), 5, 0, width - 10, height,
+                auto offset = owner.searchOffsets[rowNumber];
+                auto label = file.getFileName();
+                
+                // Long files that matched past their first window say where
+                if (offset > 0.0f)
+                    label << "  @ " << (int) offset / 60 << ":" << juce::String((int) offset % 60).paddedLeft('0', 2);
+                
+                g.drawText(label, 5, 0, width - 10, height,
                           juce::Justification::centredLeft, true);
             }
         }
@@ -78,5 +126,42 @@ private:
     
     std::unique_ptr<ResultsListBoxModel> resultsModel;
     
+    class SuggestionsListBoxModel : public juce::ListBoxModel
+    {
+    public:
+        SuggestionsListBoxModel(SoundSiftAudioProcessorEditor& owner) : owner(owner) {}
+        
+        int getNumRows() override
+        {
+            return owner.suggestions.size();
+        }
+        
+        void paintListBoxItem(int rowNumber, juce::Graphics& g,
+                            int width, int height, bool rowIsSelected) override
+        {
+            g.fillAll(rowIsSelected ? juce::Colours::lightblue : juce::Colours::white);
+            g.setColour(juce::Colours::black);
+            
+            if (rowNumber < owner.suggestions.size())
+                g.drawText(owner.suggestions[rowNumber], 5, 0, width - 10, height,
+                          juce::Justification::centredLeft, true);
+        }
+        
+        void listBoxItemClicked(int row, const juce::MouseEvent&) override
+        {
+            owner.suggestionClicked(row);
+        }
+        
+        void returnKeyPressed(int row) override
+        {
+            owner.suggestionClicked(row);
+        }
+        
+    private:
+        SoundSiftAudioProcessorEditor& owner;
+    };
+    
+    std::unique_ptr<SuggestionsListBoxModel> suggestionsModel;
+    
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SoundSiftAudioProcessorEditor)
 };
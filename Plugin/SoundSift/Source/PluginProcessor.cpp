@@ -22,11 +22,16 @@ SoundSiftAudioProcessor::SoundSiftAudioProcessor()
                        )
 #endif
 {
-    formatManager.registerBasicFormats();
+    apiClient.setWorkers(&core->workers);
+    apiClient.setIpc(core->ipc);
+    sampler->setMonitor (&perfMonitor);
+    startWarmUp();
 }
 
 SoundSiftAudioProcessor::~SoundSiftAudioProcessor()
 {
+    stopTimer();
+    transportSource.setSource (nullptr);
 }
 
 //==============================================================================
@@ -94,7 +99,9 @@ void SoundSiftAudioProcessor::changeProgramName (int index, const juce::String&
 //==============================================================================
 void SoundSiftAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
+    perfMonitor.prepare (sampleRate, samplesPerBlock);
     transportSource.prepareToPlay(samplesPerBlock, sampleRate);
+    sampler->prepare (sampleRate);
 //    if (audioPlayer != nullptr)
 //        audioPlayer->prepareToPlay(samplesPerBlock, sampleRate);
 }
@@ -137,6 +144,8 @@ void SoundSiftAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer,
                                             juce::MidiBuffer& midiMessages)
 {
     juce::ScopedNoDenormals noDenormals;
+    AudioPerfMonitor::ScopedBlock timing (perfMonitor, buffer.getNumSamples());
+    
         auto totalNumInputChannels  = getTotalNumInputChannels();
         auto totalNumOutputChannels = getTotalNumOutputChannels();
 
@@ -146,17 +155,164 @@ void SoundSiftAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer,
         // The TransportSource writes directly into the buffer
         juce::AudioSourceChannelInfo audioSourceBuffer (&buffer, 0, buffer.getNumSamples());
         transportSource.getNextAudioBlock (audioSourceBuffer);
+        
+        // Kit voices triggered by incoming MIDI are mixed on top
+        sampler->renderNextBlock (buffer, midiMessages);
 }
 
-void SoundSiftAudioProcessor::loadFile (const juce::File& file)
+void SoundSiftAudioProcessor::setNonRealtime (bool isNonRealtime) noexcept
 {
-    auto* reader = formatManager.createReaderFor (file);
-    if (reader != nullptr)
+    AudioProcessor::setNonRealtime (isNonRealtime);
+    renderingOffline = isNonRealtime;
+}
+
+void SoundSiftAudioProcessor::loadFile (const juce::File& file, double startSeconds, float gainDb)
+{
+    auto generation = ++loadGeneration;
+    
+    // Short samples play from memory, decoded once for every instance
+    auto preview = core->findPreview (file);
+    if (preview.buffer != nullptr)
     {
-        auto newSource = std::make_unique<juce::AudioFormatReaderSource> (reader, true);
-        transportSource.setSource (newSource.get(), 0, nullptr, reader->sampleRate);
+        playFromMemory (preview);
+    }
+    else
+    {
+        auto* reader = core->formatManager.createReaderFor (file);
+        if (reader == nullptr)
+            return;
+        
+        // Longer files stream from disk on the shared read-ahead thread, so
+        // the audio thread never waits on a read; a block it plays before
+        // the buffer catches up is counted as a disk underrun
+        auto sampleRate = reader->sampleRate;
+        auto shortEnough = (double) reader->lengthInSamples <= SharedCore::maxPreviewSeconds * sampleRate;
+        auto newSource = std::make_unique<MonitoredBufferingSource> (new juce::AudioFormatReaderSource (reader, true),
+                                                                     core->readAheadThread, streamReadAheadSamples,
+                                                                     2, perfMonitor, renderingOffline);
+        transportSource.setSource (newSource.get(), 0, nullptr, sampleRate);
         readerSource.reset (newSource.release());
+        previewBuffer.reset();
+        
+        // A short one not decoded yet streams too, while a worker decodes
+        // it; the decoded copy takes over if it's still the loaded file and
+        // isn't playing by then
+        if (shortEnough)
+        {
+            std::weak_ptr<bool> alive = lifetime;
+            auto* shared = &core.getObject();
+            
+            shared->workers.addJob ([this, alive, shared, file, generation]
+            {
+                auto decoded = shared->getPreview (file);
+                if (decoded.buffer == nullptr)
+                    return;
+                
+                juce::MessageManager::callAsync ([this, alive, decoded, generation]
+                {
+                    if (alive.expired() || generation != loadGeneration || transportSource.isPlaying())
+                        return;
+                    
+                    auto position = transportSource.getCurrentPosition();
+                    auto gain = transportSource.getGain();
+                    playFromMemory (decoded);
+                    transportSource.setPosition (position);
+                    transportSource.setGain (gain);
+                });
+            });
+        }
     }
+    
+    previewStart = juce::jlimit (0.0, juce::jmax (0.0, transportSource.getLengthInSeconds()), startSeconds);
+    transportSource.setPosition (previewStart);
+    transportSource.setGain (juce::Decibels::decibelsToGain (gainDb));
+}
+
+void SoundSiftAudioProcessor::playFromMemory (const SharedCore::Preview& preview)
+{
+    auto newSource = std::make_unique<juce::MemoryAudioSource> (*preview.buffer, false);
+    transportSource.setSource (newSource.get(), 0, nullptr, preview.sampleRate);
+    readerSource.reset (newSource.release());
+    previewBuffer = preview.buffer;
+}
+
+SoundSiftAudioProcessor::PreviewPlacement SoundSiftAudioProcessor::placementFor (const ApiClient::SearchResult& result) const
+{
+    auto descriptors = core->descriptorsFor (result.library, result.id);
+    PreviewPlacement placement;
+    
+    // A long file starts at its best matching window, anything else just
+    // before its first non-silent sample
+    if (result.offset > 0.0f)
+        placement.startSeconds = result.offset;
+    else if (std::isfinite (descriptors.leadingSilence))
+        placement.startSeconds = juce::jmax (0.0, (double) descriptors.leadingSilence - previewPreRollSeconds);
+    
+    // Toward the target loudness, but never pushing the peak past the ceiling
+    if (std::isfinite (descriptors.lufs) && std::isfinite (descriptors.peakDb))
+        placement.gainDb = juce::jlimit (-previewMaxGainDb, previewMaxGainDb,
+                                         juce::jmin (previewTargetLufs - descriptors.lufs,
+                                                     previewPeakCeilingDb - descriptors.peakDb));
+    
+    return placement;
+}
+
+void SoundSiftAudioProcessor::loadResult (const ApiClient::SearchResult& result)
+{
+    auto placement = placementFor (result);
+    loadFile (juce::File (result.path), placement.startSeconds, placement.gainDb);
+}
+
+void SoundSiftAudioProcessor::loadKit (const juce::Array<ApiClient::SearchResult>& results)
+{
+    struct Entry
+    {
+        juce::File file;
+        PreviewPlacement placement;
+    };
+    
+    // Descriptor lookups here, decoding on a worker
+    std::vector<Entry> entries;
+    for (int i = 0; i < juce::jmin (results.size(), PreviewSampler::maxSlots); ++i)
+        entries.push_back ({ juce::File (results.getReference (i).path), placementFor (results.getReference (i)) });
+    
+    auto kit = sampler;
+    auto* shared = &core.getObject();
+    auto generation = kit->beginKit ((int) entries.size());
+    
+    shared->workers.addJob ([kit, shared, entries, generation]
+    {
+        for (int slot = 0; slot < PreviewSampler::maxSlots; ++slot)
+        {
+            // A newer kit is loading; leave the slots to it
+            if (! kit->isCurrentKit (generation))
+                return;
+            
+            std::unique_ptr<PreviewSampler::Sample> sample;
+            
+            // Only files short enough for the preview cache are playable;
+            // longer ones leave their note silent
+            if (slot < (int) entries.size())
+            {
+                auto& entry = entries[(size_t) slot];
+                auto preview = shared->getPreview (entry.file);
+                
+                if (preview.buffer != nullptr)
+                {
+                    sample = std::make_unique<PreviewSampler::Sample>();
+                    sample->buffer = preview.buffer;
+                    sample->sampleRate = preview.sampleRate;
+                    sample->startSample = juce::jlimit (0, juce::jmax (0, preview.buffer->getNumSamples() - 1),
+                                                        (int) (entry.placement.startSeconds * preview.sampleRate));
+                    sample->gain = juce::Decibels::decibelsToGain (entry.placement.gainDb);
+                }
+            }
+            
+            // Dropped if a newer kit began while this one decoded
+            if (! kit->setSlot (slot, std::move (sample), generation) && ! kit->isCurrentKit (generation))
+                return;
+        }
+    });
 }
 
 //==============================================================================
@@ -171,17 +327,147 @@ juce::AudioProcessorEditor* SoundSiftAudioProcessor::createEditor()
 }
 
 //==============================================================================
+SoundSiftAudioProcessor::Session SoundSiftAudioProcessor::getSession() const
+{
+    const juce::ScopedLock lock (sessionLock);
+    return session;
+}
+
+void SoundSiftAudioProcessor::setSession (const Session& newSession)
+{
+    const juce::ScopedLock lock (sessionLock);
+    session = newSession;
+}
+
+//==============================================================================
+void SoundSiftAudioProcessor::startWarmUp()
+{
+    stopTimer();
+    
+    if (readiness.load() != Readiness::offline)
+        setReadiness (Readiness::connecting);
+    
+    std::weak_ptr<bool> alive = lifetime;
+    
+    apiClient.getStatus ([this, alive] (bool success, juce::var status)
+    {
+        if (alive.expired())
+            return;
+        
+        if (! success)
+        {
+            // Server not up yet (or gone); keep knocking
+            setReadiness (Readiness::offline);
+            startTimer (warmUpRetryMs);
+            return;
+        }
+        
+        core->connectIpc (status["ipc"]);
+        
+        if ((bool) status.getProperty ("ready", false))
+        {
+            setReadiness (Readiness::ready);
+            return;
+        }
+        
+        setReadiness (Readiness::warming);
+        
+        apiClient.loadIndex ([this, alive] (bool loaded, juce::var response)
+        {
+            if (alive.expired())
+                return;
+            
+            if (loaded && (bool) response.getProperty ("ready", false))
+            {
+                setReadiness (Readiness::ready);
+            }
+            else
+            {
+                setReadiness (Readiness::offline);
+                startTimer (warmUpRetryMs);
+            }
+        });
+    });
+}
+
+void SoundSiftAudioProcessor::timerCallback()
+{
+    startWarmUp();
+}
+
+void SoundSiftAudioProcessor::setReadiness (Readiness newReadiness)
+{
+    if (readiness.exchange (newReadiness) != newReadiness)
+        sendChangeMessage();
+}
+
+// State is a ValueTree in JUCE's binary format, which keeps a few dozen
+// results well under the size of the equivalent XML
 void SoundSiftAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
+    auto current = getSession();
+    
+    juce::ValueTree state ("SoundSiftSession");
+    state.setProperty ("version", 1, nullptr);
+    state.setProperty ("query", current.query, nullptr);
+    state.setProperty ("topK", current.topK, nullptr);
+    state.setProperty ("selectedRow", current.selectedRow, nullptr);
+    state.setProperty ("indexVersion", current.indexVersion, nullptr);
+    state.setProperty ("localSearch", current.localSearch, nullptr);
+    
+    for (auto& result : current.results)
+    {
+        juce::ValueTree item ("Result");
+        item.setProperty ("path", result.path, nullptr);
+        item.setProperty ("library", result.library, nullptr);
+        item.setProperty ("id", result.id, nullptr);
+        item.setProperty ("score", result.score, nullptr);
+        item.setProperty ("offset", result.offset, nullptr);
+        state.appendChild (item, nullptr);
+    }
+    
+    juce::MemoryOutputStream stream (destData, false);
+    state.writeToStream (stream);
 }
 
 void SoundSiftAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
-    // You should use this method to restore your parameters from this memory block,
-    // whose contents will have been created by the getStateInformation() call.
+    auto state = juce::ValueTree::readFromData (data, (size_t) sizeInBytes);
+    
+    if (! state.hasType ("SoundSiftSession"))
+        return;
+    
+    Session restored;
+    restored.query = state["query"].toString();
+    restored.topK = juce::jlimit (1, 50, (int) state.getProperty ("topK", 10));
+    restored.selectedRow = state.getProperty ("selectedRow", -1);
+    restored.indexVersion = state["indexVersion"].toString();
+    restored.localSearch = state.getProperty ("localSearch", false);
+    
+    for (auto item : state)
+    {
+        ApiClient::SearchResult result;
+        result.path = item["path"].toString();
+        result.library = item["library"].toString();
+        result.id = item.getProperty ("id", -1);
+        result.score = (float) (double) item.getProperty ("score", 0.0);
+        result.offset = (float) (double) item.getProperty ("offset", 0.0);
+        restored.results.add (result);
+    }
+    
+    if (! juce::isPositiveAndBelow (restored.selectedRow, restored.results.size()))
+        restored.selectedRow = -1;
+    
+    setSession (restored);
+    
+    // Bring back the previewed sample too, so play works straight away
+    if (restored.selectedRow >= 0)
+    {
+        auto& preview = restored.results.getReference (restored.selectedRow);
+        
+        if (juce::File (preview.path).existsAsFile())
+            loadResult (preview);
+    }
 }
 
 //==============================================================================
@@ -1,8 +1,14 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "ApiClient.h"
+#include "AudioPerfMonitor.h"
+#include "PreviewSampler.h"
+#include "SharedCore.h"
 
-class SoundSiftAudioProcessor  : public juce::AudioProcessor
+class SoundSiftAudioProcessor  : public juce::AudioProcessor,
+                                 public juce::ChangeBroadcaster,
+                                 private juce::Timer
 {
 public:
     //==============================================================================
@@ -16,6 +22,7 @@ public:
         bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
        #endif
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void setNonRealtime (bool isNonRealtime) noexcept override;
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -42,15 +49,114 @@ public:
     //==============================================================================
     // PUBLIC AUDIO MEMBERS
     // We make these public so the Editor (GUI) can access them to load files/start/stop
-    juce::AudioFormatManager formatManager;
     juce::AudioTransportSource transportSource;
     
-    // Helper to load a file safely from the Editor
-    void loadFile (const juce::File& file);
+    // Format manager, mapped index, caches and worker threads, shared by
+    // every SoundSift instance in the process
+    juce::SharedResourcePointer<SharedCore> core;
+    
+    // Helper to load a file safely from the Editor. Playback starts, and
+    // returns to on stop, at startSeconds, with gainDb applied.
+    void loadFile (const juce::File& file, double startSeconds = 0.0, float gainDb = 0.0f);
+    
+    // Loads a search result at its best matching window (or past its
+    // leading silence) and at the preview loudness, from the backend's
+    // descriptors; a plain loadFile when the sample hasn't been analysed
+    void loadResult (const ApiClient::SearchResult& result);
+    
+    double getPreviewStart() const { return previewStart; }
+    
+    // Makes the first PreviewSampler::maxSlots results playable from MIDI,
+    // result i on note PreviewSampler::baseNote + i. Samples are decoded on
+    // the shared workers and handed to the audio thread as they're ready.
+    void loadKit (const juce::Array<ApiClient::SearchResult>& results);
+    
+    PreviewSampler& getSampler() { return *sampler; }
+    
+    // Per-block timing, xruns, disk underruns and starved kit notes,
+    // written by processBlock and readable from any thread
+    AudioPerfMonitor& getPerfMonitor() { return perfMonitor; }
+    
+    static constexpr float previewTargetLufs = -16.0f;
+    static constexpr float previewPeakCeilingDb = -1.0f;
+    static constexpr float previewMaxGainDb = 24.0f;
+    static constexpr double previewPreRollSeconds = 0.005;
+    
+    // Read-ahead for files too long to decode into memory, per channel
+    static constexpr int streamReadAheadSamples = 32768;
+    
+    //==============================================================================
+    // The last search, saved with the plugin state so reopening the editor
+    // or the project shows it again without a round trip
+    struct Session
+    {
+        juce::String query;         // as typed, filter tokens included
+        int topK = 10;
+        juce::Array<ApiClient::SearchResult> results;
+        int selectedRow = -1;
+        juce::String indexVersion;  // server index_version the results came from
+        bool localSearch = false;   // plain queries searched in process (SharedCore::searchLocal)
+    };
+    
+    Session getSession() const;
+    void setSession (const Session& newSession);
+    
+    //==============================================================================
+    // Started at construction: wait for the server, then have it page in the
+    // index and warm the text model so the first search is a warm one.
+    // Change messages go out whenever the state moves.
+    enum class Readiness { connecting, warming, ready, offline };
+    
+    Readiness getReadiness() const { return readiness.load(); }
+    void startWarmUp();
 
 private:
     // This holds the actual audio data reader. It must stay alive as long as the source is playing.
-    std::unique_ptr<juce::AudioFormatReaderSource> readerSource;
+    std::unique_ptr<juce::PositionableAudioSource> readerSource;
+    
+    // Decoded preview from the shared cache that readerSource plays from
+    std::shared_ptr<juce::AudioBuffer<float>> previewBuffer;
+    double previewStart = 0.0;
+    
+    // Bumped by every loadFile, so a background decode only swaps in for
+    // the file that is still loaded
+    std::atomic<int> loadGeneration { 0 };
+    
+    void playFromMemory (const SharedCore::Preview& preview);
+    
+    // Where and how loud a result starts, from its descriptors
+    struct PreviewPlacement
+    {
+        double startSeconds = 0.0;
+        float gainDb = 0.0f;
+    };
+    
+    PreviewPlacement placementFor (const ApiClient::SearchResult& result) const;
+    
+    AudioPerfMonitor perfMonitor;
+    
+    // Set while the host renders offline, so streamed previews wait for
+    // the disk rather than playing silence
+    std::atomic<bool> renderingOffline { false };
+    
+    // Shared with kit loading jobs, which may finish after the processor
+    std::shared_ptr<PreviewSampler> sampler = std::make_shared<PreviewSampler>();
+    
+    // Hosts may save and restore state off the message thread
+    juce::CriticalSection sessionLock;
+    Session session;
+    
+    void timerCallback() override;
+    void setReadiness (Readiness newReadiness);
+    
+    static constexpr int warmUpRetryMs = 2000;
+    
+    ApiClient apiClient;
+    std::atomic<Readiness> readiness { Readiness::connecting };
+    
+    // Server callbacks outlive the processor if it's deleted mid-request;
+    // they hold a weak_ptr to this and bail out once it has expired
+    std::shared_ptr<bool> lifetime = std::make_shared<bool> (true);
     
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SoundSiftAudioProcessor)
@@ -0,0 +1,421 @@
+#pragma once
+#include <JuceHeader.h>
+#include "AudioPerfMonitor.h"
+
+// Plays search results as a kit: slot i sounds on MIDI note baseNote + i,
+// one-shot, with overlapping voices. Built for the audio thread:
+//
+//  - voices and the command queue are fixed arrays allocated up front
+//  - samples are decoded elsewhere and handed over as pointers through a
+//    single-consumer lock-free FIFO; the audio thread never locks
+//  - notes start on the exact sample the MIDI event carries
+//  - a replaced sample goes back to the producer side to be freed once
+//    no voice is playing it, so nothing is deallocated in renderNextBlock
+//
+// Producers (setSlot, trigger, stopAll) may be called from any thread; they
+// serialise among themselves on a lock the audio thread never touches.
+class PreviewSampler
+{
+public:
+    static constexpr int maxSlots = 16;
+    static constexpr int maxVoices = 32;
+    static constexpr int baseNote = 36;  // C1, the GM kick, bottom-left pad on most controllers
+    static constexpr int fadeSamples = 64;
+
+    struct Sample
+    {
+        std::shared_ptr<juce::AudioBuffer<float>> buffer;
+        double sampleRate = 44100.0;
+        int startSample = 0;
+        float gain = 1.0f;
+    };
+
+    PreviewSampler() = default;
+
+    ~PreviewSampler()
+    {
+        // Audio has stopped by now; whatever the slots point at is in owned
+        std::fill(std::begin(slots), std::end(slots), nullptr);
+    }
+
+    // ---------- PRODUCER SIDE ----------
+
+    // Puts sample on note baseNote + slot, replacing what was there.
+    // Returns false if the queue is full or slot is out of range, or if
+    // generation (from beginKit; 0 for none) is no longer the current kit.
+    // The check and the push share producerLock with beginKit, so an
+    // older loader can never land a slot after a newer kit has begun.
+    bool setSlot(int slot, std::unique_ptr<Sample> sample, int generation = 0)
+    {
+        if (! juce::isPositiveAndBelow(slot, maxSlots))
+            return false;
+
+        const juce::SpinLock::ScopedLockType lock(producerLock);
+
+        if (generation != 0 && generation != kitGeneration.load())
+            return false;
+
+        collectGarbageLocked();
+
+        auto* raw = sample.get();
+        if (raw != nullptr)
+            owned.push_back(std::move(sample));
+
+        if (! push({ Command::setSlot, slot, 0.0f, raw }))
+        {
+            if (raw != nullptr)
+                owned.pop_back();
+            return false;
+        }
+
+        return true;
+    }
+
+    void clearSlots()
+    {
+        for (int slot = 0; slot < maxSlots; ++slot)
+            setSlot(slot, nullptr);
+    }
+
+    // Plays a slot from the GUI, at the start of the next block
+    bool trigger(int slot, float velocity = 1.0f)
+    {
+        const juce::SpinLock::ScopedLockType lock(producerLock);
+        return push({ Command::noteOn, baseNote + slot, velocity, nullptr });
+    }
+
+    bool stopAll()
+    {
+        const juce::SpinLock::ScopedLockType lock(producerLock);
+        return push({ Command::allOff, 0, 0.0f, nullptr });
+    }
+
+    // Loads are numbered so a newer kit can tell older loaders to give up.
+    // The first numSlots slots count as loading until their setSlot lands.
+    int beginKit(int numSlots = maxSlots)
+    {
+        const juce::SpinLock::ScopedLockType lock(producerLock);
+        pendingSlots.store(numSlots >= maxSlots ? allSlots : (juce::uint32) ((1u << juce::jmax(0, numSlots)) - 1u));
+        return ++kitGeneration;
+    }
+
+    bool isCurrentKit(int generation) const { return kitGeneration.load() == generation; }
+
+    // Notes that arrive for a slot still loading are reported here as
+    // starved. Set before playback starts.
+    void setMonitor(AudioPerfMonitor* newMonitor) { monitor = newMonitor; }
+
+    // ---------- AUDIO THREAD ----------
+
+    void prepare(double newSampleRate)
+    {
+        sampleRate = newSampleRate;
+    }
+
+    // Adds the sampler's voices into buffer, starting and choking notes at
+    // the sample offsets of the MIDI events
+    void renderNextBlock(juce::AudioBuffer<float>& buffer, const juce::MidiBuffer& midi)
+    {
+        applyCommands();
+
+        auto numSamples = buffer.getNumSamples();
+        auto position = 0;
+
+        for (const auto metadata : midi)
+        {
+            auto eventPosition = juce::jlimit(0, numSamples, metadata.samplePosition);
+            render(buffer, position, eventPosition - position);
+            position = eventPosition;
+            handleMidi(metadata.data, metadata.numBytes);
+        }
+
+        render(buffer, position, numSamples - position);
+        releaseRetired();
+    }
+
+    int getActiveVoices() const { return activeVoices.load(); }
+
+private:
+    struct Command
+    {
+        enum Type { setSlot, noteOn, allOff };
+
+        Type type;
+        int value;       // slot for setSlot, note for noteOn
+        float velocity;
+        const Sample* sample;
+    };
+
+    struct Voice
+    {
+        const Sample* sample = nullptr;
+        int note = -1;
+        double position = 0.0;
+        double increment = 1.0;
+        float gain = 0.0f;
+        int fadeRemaining = -1;  // counting down to silence once choked; -1 while playing
+        juce::uint64 startedAt = 0;
+    };
+
+    static constexpr int queueSize = 256;
+    static constexpr juce::uint32 allSlots = (juce::uint32) ((1ull << maxSlots) - 1);
+
+    bool push(const Command& command)
+    {
+        int start1, size1, start2, size2;
+        commandFifo.prepareToWrite(1, start1, size1, start2, size2);
+
+        if (size1 + size2 < 1)
+            return false;
+
+        commands[(size_t) (size1 > 0 ? start1 : start2)] = command;
+        commandFifo.finishedWrite(1);
+        return true;
+    }
+
+    // Frees samples the audio thread has handed back
+    void collectGarbageLocked()
+    {
+        int start1, size1, start2, size2;
+        auto ready = returnFifo.getNumReady();
+        returnFifo.prepareToRead(ready, start1, size1, start2, size2);
+
+        auto release = [this](const Sample* sample)
+        {
+            auto it = std::find_if(owned.begin(), owned.end(),
+                                   [sample](auto& s) { return s.get() == sample; });
+            if (it != owned.end())
+                owned.erase(it);
+        };
+
+        for (int i = 0; i < size1; ++i) release(returned[(size_t) (start1 + i)]);
+        for (int i = 0; i < size2; ++i) release(returned[(size_t) (start2 + i)]);
+
+        returnFifo.finishedRead(size1 + size2);
+    }
+
+    void applyCommands()
+    {
+        int start1, size1, start2, size2;
+        commandFifo.prepareToRead(commandFifo.getNumReady(), start1, size1, start2, size2);
+
+        for (int i = 0; i < size1; ++i) apply(commands[(size_t) (start1 + i)]);
+        for (int i = 0; i < size2; ++i) apply(commands[(size_t) (start2 + i)]);
+
+        commandFifo.finishedRead(size1 + size2);
+    }
+
+    void apply(const Command& command)
+    {
+        switch (command.type)
+        {
+            case Command::setSlot:
+                retire(slots[command.value]);
+                slots[command.value] = command.sample;
+                pendingSlots.fetch_and(~(1u << command.value), std::memory_order_relaxed);
+                break;
+
+            case Command::noteOn:
+                noteOn(command.value, command.velocity);
+                break;
+
+            case Command::allOff:
+                for (auto& voice : voices)
+                    choke(voice);
+                break;
+        }
+    }
+
+    void handleMidi(const juce::uint8* data, int numBytes)
+    {
+        if (numBytes < 3)
+            return;
+
+        auto status = data[0] & 0xf0;
+
+        if (status == 0x90 && data[2] > 0)
+            noteOn(data[1], (float) data[2] / 127.0f);
+        else if (status == 0xb0 && (data[1] == 120 || data[1] == 123))  // all sound / all notes off
+            for (auto& voice : voices)
+                choke(voice);
+
+        // Note-offs are ignored: slots are one-shots and play to the end
+    }
+
+    void noteOn(int note, float velocity)
+    {
+        auto slot = note - baseNote;
+        if (! juce::isPositiveAndBelow(slot, maxSlots) || sampleRate <= 0.0)
+            return;
+
+        if (slots[slot] == nullptr)
+        {
+            if (monitor != nullptr && (pendingSlots.load(std::memory_order_relaxed) & (1u << slot)) != 0)
+                monitor->recordStarvedNote();
+            return;
+        }
+
+        // Retriggering a note chokes the voice it was already sounding on
+        Voice* free = nullptr;
+        Voice* oldest = &voices[0];
+
+        for (auto& voice : voices)
+        {
+            if (voice.sample != nullptr && voice.note == note)
+                choke(voice);
+
+            if (voice.sample == nullptr && free == nullptr)
+                free = &voice;
+
+            if (voice.startedAt < oldest->startedAt)
+                oldest = &voice;
+        }
+
+        // Out of voices: the oldest is cut
+        auto& voice = free != nullptr ? *free : *oldest;
+        auto* sample = slots[slot];
+
+        voice.sample = sample;
+        voice.note = note;
+        voice.position = (double) sample->startSample;
+        voice.increment = sample->sampleRate / sampleRate;
+        voice.gain = sample->gain * velocity;
+        voice.fadeRemaining = -1;
+        voice.startedAt = ++voiceCounter;
+    }
+
+    static void choke(Voice& voice)
+    {
+        if (voice.sample != nullptr && voice.fadeRemaining < 0)
+            voice.fadeRemaining = fadeSamples;
+    }
+
+    void render(juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+    {
+        if (numSamples <= 0)
+            return;
+
+        int active = 0;
+
+        for (auto& voice : voices)
+        {
+            if (voice.sample == nullptr)
+                continue;
+
+            auto& source = *voice.sample->buffer;
+            auto sourceLength = source.getNumSamples();
+            auto sourceChannels = source.getNumChannels();
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                auto index = (int) voice.position;
+
+                if (index + 1 >= sourceLength || voice.fadeRemaining == 0)
+                {
+                    voice.sample = nullptr;
+                    break;
+                }
+
+                auto frac = (float) (voice.position - (double) index);
+                auto gain = voice.gain;
+
+                if (voice.fadeRemaining > 0)
+                    gain *= (float) voice.fadeRemaining-- / (float) fadeSamples;
+
+                for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+                {
+                    auto* in = source.getReadPointer(juce::jmin(channel, sourceChannels - 1));
+                    auto value = in[index] + frac * (in[index + 1] - in[index]);
+                    buffer.addSample(channel, startSample + i, value * gain);
+                }
+
+                voice.position += voice.increment;
+            }
+
+            if (voice.sample != nullptr)
+                ++active;
+        }
+
+        activeVoices.store(active, std::memory_order_relaxed);
+    }
+
+    // A sample leaving its slot may still be sounding; it is handed back
+    // once its last voice has finished
+    void retire(const Sample* sample)
+    {
+        if (sample == nullptr)
+            return;
+
+        for (auto& pending : retired)
+        {
+            if (pending == nullptr)
+            {
+                pending = sample;
+                return;
+            }
+        }
+
+        // Retire list full (the producer can only have queueSize commands
+        // outstanding, so this needs a flood of replacements): hand back the
+        // oldest now and cut its voices
+        for (auto& voice : voices)
+            if (voice.sample == retired[0])
+                voice.sample = nullptr;
+
+        handBack(retired[0]);
+        retired[0] = sample;
+    }
+
+    void releaseRetired()
+    {
+        for (auto& pending : retired)
+        {
+            if (pending == nullptr)
+                continue;
+
+            auto playing = std::any_of(std::begin(voices), std::end(voices),
+                                       [pending](const Voice& v) { return v.sample == pending; });
+
+            if (! playing && handBack(pending))
+                pending = nullptr;
+        }
+    }
+
+    bool handBack(const Sample* sample)
+    {
+        int start1, size1, start2, size2;
+        returnFifo.prepareToWrite(1, start1, size1, start2, size2);
+
+        if (size1 + size2 < 1)
+            return false;
+
+        returned[(size_t) (size1 > 0 ? start1 : start2)] = sample;
+        returnFifo.finishedWrite(1);
+        return true;
+    }
+
+    // Producer side
+    juce::SpinLock producerLock;
+    std::vector<std::unique_ptr<Sample>> owned;
+    std::atomic<int> kitGeneration { 0 };
+
+    // Producer -> audio thread
+    juce::AbstractFifo commandFifo { queueSize };
+    std::array<Command, queueSize> commands {};
+    std::atomic<juce::uint32> pendingSlots { 0 };  // bit per slot, cleared as setSlot lands
+    AudioPerfMonitor* monitor = nullptr;
+
+    // Audio thread -> producer, samples safe to free
+    juce::AbstractFifo returnFifo { queueSize };
+    std::array<const Sample*, queueSize> returned {};
+
+    // Audio thread only
+    double sampleRate = 0.0;
+    const Sample* slots[maxSlots] = {};
+    const Sample* retired[maxSlots * 2] = {};
+    Voice voices[maxVoices];
+    juce::uint64 voiceCounter = 0;
+    std::atomic<int> activeVoices { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE(PreviewSampler)
+};
@@ -0,0 +1,133 @@
+#pragma once
+#include <JuceHeader.h>
+
+// Span-level timing for requests made through ApiClient. Spans land in a
+// fixed-size ring buffer (oldest dropped first) and can be exported as
+// Chrome trace JSON, which chrome://tracing and ui.perfetto.dev open.
+class SearchTrace
+{
+public:
+    struct Span
+    {
+        juce::String name;
+        juce::String category;
+        int traceId = 0;
+        juce::int64 startMicros = 0;
+        juce::int64 durationMicros = 0;
+        juce::uint64 threadId = 0;
+    };
+
+    static constexpr int spanCapacity = 4096;
+    static constexpr int latencyCapacity = 256;
+
+    static juce::int64 nowMicros()
+    {
+        return (juce::int64) (juce::Time::getMillisecondCounterHiRes() * 1000.0);
+    }
+
+    int beginTrace()
+    {
+        return ++lastTraceId;
+    }
+
+    void addSpan(int traceId, const juce::String& name, const juce::String& category,
+                 juce::int64 startMicros, juce::int64 endMicros)
+    {
+        Span span;
+        span.name = name;
+        span.category = category;
+        span.traceId = traceId;
+        span.startMicros = startMicros;
+        span.durationMicros = juce::jmax((juce::int64) 0, endMicros - startMicros);
+        span.threadId = (juce::uint64) (juce::pointer_sized_uint) juce::Thread::getCurrentThreadId();
+
+        const juce::SpinLock::ScopedLockType lock(spanLock);
+        spans[(size_t) (nextSpan++ % spanCapacity)] = std::move(span);
+    }
+
+    // End-to-end request time, used for the p50/p99 readout
+    void addLatency(juce::int64 durationMicros)
+    {
+        const juce::SpinLock::ScopedLockType lock(spanLock);
+        latencies[(size_t) (nextLatency++ % latencyCapacity)] = durationMicros;
+    }
+
+    // Percentile of recent end-to-end latencies in ms, or -1 with no data
+    double latencyPercentileMs(double p) const
+    {
+        std::vector<juce::int64> recent;
+        {
+            const juce::SpinLock::ScopedLockType lock(spanLock);
+            auto n = juce::jmin(nextLatency, (juce::int64) latencyCapacity);
+            recent.assign(latencies.begin(), latencies.begin() + n);
+        }
+
+        if (recent.empty())
+            return -1.0;
+
+        std::sort(recent.begin(), recent.end());
+        auto index = (size_t) juce::roundToInt(p * (double) (recent.size() - 1));
+        return (double) recent[index] / 1000.0;
+    }
+
+    juce::String latencySummary() const
+    {
+        auto p50 = latencyPercentileMs(0.5);
+
+        if (p50 < 0.0)
+            return {};
+
+        return "p50 " + juce::String(p50, 1) + " ms / p99 "
+             + juce::String(latencyPercentileMs(0.99), 1) + " ms";
+    }
+
+    juce::String toChromeTraceJson() const
+    {
+        std::vector<Span> recent;
+        {
+            const juce::SpinLock::ScopedLockType lock(spanLock);
+            auto first = juce::jmax((juce::int64) 0, nextSpan - spanCapacity);
+
+            for (auto i = first; i < nextSpan; ++i)
+                recent.push_back(spans[(size_t) (i % spanCapacity)]);
+        }
+
+        juce::Array<juce::var> events;
+
+        for (auto& span : recent)
+        {
+            juce::DynamicObject::Ptr args = new juce::DynamicObject();
+            args->setProperty("trace", span.traceId);
+
+            juce::DynamicObject::Ptr event = new juce::DynamicObject();
+            event->setProperty("name", span.name);
+            event->setProperty("cat", span.category);
+            event->setProperty("ph", "X");
+            event->setProperty("ts", span.startMicros);
+            event->setProperty("dur", span.durationMicros);
+            event->setProperty("pid", 1);
+            event->setProperty("tid", (juce::int64) span.threadId);
+            event->setProperty("args", juce::var(args.get()));
+            events.add(juce::var(event.get()));
+        }
+
+        juce::DynamicObject::Ptr root = new juce::DynamicObject();
+        root->setProperty("traceEvents", events);
+        root->setProperty("displayTimeUnit", "ms");
+        return juce::JSON::toString(juce::var(root.get()), true);
+    }
+
+    bool exportChromeTrace(const juce::File& file) const
+    {
+        return file.replaceWithText(toChromeTraceJson());
+    }
+
+private:
+    std::atomic<int> lastTraceId { 0 };
+
+    mutable juce::SpinLock spanLock;
+    std::array<Span, spanCapacity> spans;
+    std::array<juce::int64, latencyCapacity> latencies {};
+    juce::int64 nextSpan = 0;
+    juce::int64 nextLatency = 0;
+};
@@ -0,0 +1,497 @@
+#pragma once
+#include <JuceHeader.h>
+#include <future>
+#include "DescriptorTable.h"
+#include "EmbeddingStore.h"
+#include "IpcTransport.h"
+#include "PathTable.h"
+#include "SearchTrace.h"
+#include "SuggestionIndex.h"
+#include "TextEncoder.h"
+
+// Everything SoundSift instances in one process can share. Hold it through
+// juce::SharedResourcePointer<SharedCore>: the first instance creates it and
+// the last one to go deletes it, so ten instances in a session cost one set
+// of mapped files, caches and threads, and all of them see warm caches.
+//
+// The mapped files and caches are guarded by one lock; everything handed
+// out is a copy or a shared_ptr, so nothing dangles when a re-index swaps
+// them underneath an instance.
+//
+// The last /status is kept on disk, so a new session maps the index and,
+// with an exported text encoder, searches before the server answers or
+// without one at all.
+class SharedCore
+{
+public:
+    struct Preview
+    {
+        std::shared_ptr<juce::AudioBuffer<float>> buffer;
+        double sampleRate = 0.0;
+    };
+
+    static constexpr int maxCachedResults = 64;
+    static constexpr double maxPreviewSeconds = 30.0;
+    static constexpr size_t previewCacheBytes = 256 * 1024 * 1024;
+
+    SharedCore()
+    {
+        formatManager.registerBasicFormats();
+        readAheadThread.startThread();
+        restoreStatus();
+    }
+
+    ~SharedCore()
+    {
+        // Jobs use the caches below, which go before the pool would
+        workers.removeAllJobs(true, 10000);
+        readAheadThread.stopThread(2000);
+    }
+
+    // Read-only after construction, so safe to use from any instance
+    juce::AudioFormatManager formatManager;
+
+    // Runs ApiClient requests and other background work for every instance
+    juce::ThreadPool workers { juce::jlimit(2, 8, juce::SystemStats::getNumCpus() / 2) };
+
+    // Fills the read-ahead buffers of previews streamed from disk
+    juce::TimeSliceThread readAheadThread { "SoundSift read-ahead" };
+
+    // Socket connection to the backend, used by every ApiClient for
+    // queries once connected (see connectIpc)
+    std::shared_ptr<IpcTransport> ipc = std::make_shared<IpcTransport>();
+
+    // ---------- TRANSPORT ----------
+
+    // Connects in the background when /status advertises the IPC
+    // transport ("ipc": {"socket", "shm"}) and no connection is up
+    void connectIpc(const juce::var& description)
+    {
+        if (! description.isObject() || ipc->isConnected())
+            return;
+
+        auto transport = ipc;
+        auto socketPath = description["socket"].toString();
+        auto sharedPath = description["shm"].toString();
+
+        workers.addJob([transport, socketPath, sharedPath]
+        {
+            if (! transport->isConnected())
+                transport->connect(socketPath, sharedPath);
+        });
+    }
+
+    // ---------- INDEX ----------
+
+    // Remaps the backend's sidecar files when the data directory or index
+    // version reported by /status moves on; a no-op otherwise. stores is
+    // /status's library name -> data directory object, one descriptors.bin
+    // per library.
+    void openIndex(const juce::File& dataDir, const juce::File& suggestionsFile,
+                   const juce::String& newIndexVersion, const juce::var& stores = {})
+    {
+        const juce::ScopedLock lock(indexLock);
+
+        if (dataDir == openDataDir && newIndexVersion == indexVersion)
+            return;
+
+        // Stores are replaced, never reopened in place: a local search may
+        // still be scanning the old ones outside the lock
+        defaultShard = std::make_shared<Shard>(dataDir);
+        suggestions.open(suggestionsFile);
+
+        descriptors.clear();
+        shards.clear();
+        if (auto* libraries = stores.getDynamicObject())
+        {
+            for (auto& library : libraries->getProperties())
+            {
+                auto name = library.name.toString();
+                auto libraryDir = juce::File(library.value.toString());
+                descriptors[name] = std::make_unique<DescriptorTable>(libraryDir.getChildFile("descriptors.bin"));
+
+                // The default store is the one mapped above
+                if (name != defaultLibrary)
+                    shards[name] = std::make_shared<Shard>(libraryDir);
+            }
+        }
+
+        openDataDir = dataDir;
+        indexVersion = newIndexVersion;
+        results.clear();
+    }
+
+    juce::String getIndexVersion() const
+    {
+        const juce::ScopedLock lock(indexLock);
+        return indexVersion;
+    }
+
+    juce::StringArray complete(const juce::String& prefix, int maxResults) const
+    {
+        const juce::ScopedLock lock(indexLock);
+        return suggestions.complete(prefix, maxResults);
+    }
+
+    juce::String pathFor(int vecIndex) const
+    {
+        const juce::ScopedLock lock(indexLock);
+        return defaultShard != nullptr ? defaultShard->paths[vecIndex] : juce::String();
+    }
+
+    DescriptorTable::Row descriptorsFor(const juce::String& library, int vecIndex) const
+    {
+        const juce::ScopedLock lock(indexLock);
+        auto table = descriptors.find(library);
+        return table != descriptors.end() ? (*table->second)[vecIndex] : DescriptorTable::Row();
+    }
+
+    // ---------- LOCAL SEARCH ----------
+
+    // Loads the text encoder /status advertises ("text_encoder": directory
+    // or null) on a worker, so the first local search doesn't wait for it
+    void openTextEncoder(const juce::var& directory)
+    {
+        if (! TextEncoder::isCompiledIn() || ! directory.isString())
+            return;
+
+        juce::File encoderDir(directory.toString());
+
+        if (encoderDir != textEncoder.getDirectory())
+            workers.addJob([this, encoderDir] { textEncoder.open(encoderDir); });
+    }
+
+    bool canSearchLocally() const
+    {
+        const juce::ScopedLock lock(indexLock);
+        return defaultShard != nullptr && defaultShard->store.isOpen() && textEncoder.isOpen();
+    }
+
+    // A /query/text response without the server: the query is encoded in
+    // process and every mapped store scanned brute force. That is the
+    // backend's semantic search only, with no lexical fusion or segment
+    // offsets, so it ranks differently from the server and is only used
+    // when asked for. Blocks for the encode and scan, which run outside
+    // indexLock on the stores mapped when it starts; returns void when it
+    // can't search, or when a store changed on disk since it was mapped.
+    juce::var searchLocal(const juce::String& text, int topK, SearchTrace* trace = nullptr)
+    {
+        auto traceId = trace != nullptr ? trace->beginTrace() : 0;
+        auto start = SearchTrace::nowMicros();
+        auto query = textEncoder.encode(text);
+        auto encoded = SearchTrace::nowMicros();
+
+        if ((int) query.size() != EmbeddingStore::dim)
+            return {};
+
+        std::vector<std::pair<juce::String, std::shared_ptr<const Shard>>> mapped;
+        juce::String version;
+
+        {
+            const juce::ScopedLock lock(indexLock);
+
+            if (defaultShard == nullptr || ! defaultShard->store.isOpen())
+                return {};
+
+            mapped.emplace_back(defaultLibrary, defaultShard);
+            for (auto& shard : shards)
+                if (shard.second->store.isOpen())
+                    mapped.emplace_back(shard.first, shard.second);
+
+            version = indexVersion;
+        }
+
+        // Rewritten by an index run this instance hasn't heard about: the
+        // rows no longer match the paths, so leave it to the server
+        for (auto& shard : mapped)
+            if (shard.second->isStale())
+                return {};
+
+        struct Candidate
+        {
+            EmbeddingStore::Hit hit;
+            juce::String library;
+            const PathTable* table;
+        };
+
+        std::vector<Candidate> candidates;
+
+        for (auto& shard : mapped)
+            for (auto& hit : shard.second->store.search(query.data(), topK))
+                candidates.push_back({ hit, shard.first, &shard.second->paths });
+
+        std::sort(candidates.begin(), candidates.end(),
+                  [](auto& a, auto& b) { return a.hit.score > b.hit.score; });
+
+        juce::Array<juce::var> results;
+
+        for (auto& candidate : candidates)
+        {
+            if (results.size() >= topK)
+                break;
+
+            juce::DynamicObject::Ptr result = new juce::DynamicObject();
+            result->setProperty("library", candidate.library);
+            result->setProperty("id", candidate.hit.index);
+            result->setProperty("score", candidate.hit.score);
+            result->setProperty("similarity", candidate.hit.score);
+            result->setProperty("path", (*candidate.table)[candidate.hit.index]);
+            result->setProperty("offset", 0.0);
+            results.add(juce::var(result.get()));
+        }
+
+        auto scanned = SearchTrace::nowMicros();
+
+        if (trace != nullptr)
+        {
+            trace->addSpan(traceId, "encode", "local", start, encoded);
+            trace->addSpan(traceId, "scan", "local", encoded, scanned);
+            trace->addSpan(traceId, "query/text", "request", start, scanned);
+            trace->addLatency(scanned - start);
+        }
+
+        juce::DynamicObject::Ptr response = new juce::DynamicObject();
+        response->setProperty("results", results);
+        response->setProperty("index_version", version);
+        response->setProperty("local", true);
+        return juce::var(response.get());
+    }
+
+    // ---------- STATUS ----------
+
+    // Remembers a successful /status for restoreStatus in later sessions
+    void saveStatus(const juce::var& status)
+    {
+        if (status.hasProperty("data_dir") && statusFile().getParentDirectory().createDirectory())
+            statusFile().replaceWithText(juce::JSON::toString(status));
+    }
+
+    // ---------- RESULTS ----------
+
+    // Recent /query/text responses for the current index version, so an
+    // instance repeating another's search doesn't go back to the server.
+    // Entries go when openIndex remaps or addResults sees another version.
+    bool findResults(const juce::String& query, juce::var& response)
+    {
+        const juce::ScopedLock lock(indexLock);
+
+        for (auto& entry : results)
+        {
+            if (entry.key == query)
+            {
+                entry.lastUsed = ++useCounter;
+                response = entry.response;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // A response from another index version means the index was rebuilt
+    // behind the mapping (by another client, or another instance's
+    // indexing): everything cached is dropped and false returned, so the
+    // caller can refresh /status to remap.
+    bool addResults(const juce::String& query, const juce::var& response)
+    {
+        const juce::ScopedLock lock(indexLock);
+
+        auto version = response["index_version"].toString();
+
+        if (indexVersion.isEmpty() || version.isEmpty())
+            return true;
+
+        if (version != indexVersion)
+        {
+            results.clear();
+            return false;
+        }
+
+        if ((int) results.size() >= maxCachedResults)
+        {
+            auto oldest = std::min_element(results.begin(), results.end(),
+                                           [](auto& a, auto& b) { return a.lastUsed < b.lastUsed; });
+            results.erase(oldest);
+        }
+
+        results.push_back({ query, response, ++useCounter });
+        return true;
+    }
+
+    // ---------- PREVIEWS ----------
+
+    // Decoded audio for short files, shared between instances and kept
+    // under previewCacheBytes. Longer files return an empty Preview and
+    // should be streamed from disk instead. Blocks for the decode, so call
+    // it from a worker; concurrent calls for one file share one decode.
+    Preview getPreview(const juce::File& file)
+    {
+        auto key = file.getFullPathName();
+        std::promise<Preview> decoded;
+        std::shared_future<Preview> inFlight;
+
+        {
+            const juce::ScopedLock lock(previewLock);
+
+            auto cached = findPreview(file);
+            if (cached.buffer != nullptr)
+                return cached;
+
+            auto pending = decoding.find(key);
+            if (pending != decoding.end())
+                inFlight = pending->second;
+            else
+                decoding[key] = decoded.get_future().share();
+        }
+
+        if (inFlight.valid())
+            return inFlight.get();
+
+        auto preview = decodePreview(file);
+
+        {
+            const juce::ScopedLock lock(previewLock);
+
+            if (preview.buffer != nullptr)
+            {
+                previewBytes += bytesOf(preview);
+                previews.push_back({ file, preview, ++useCounter });
+
+                while (previewBytes > previewCacheBytes && previews.size() > 1)
+                {
+                    auto oldest = std::min_element(previews.begin(), previews.end(),
+                                                   [](auto& a, auto& b) { return a.lastUsed < b.lastUsed; });
+                    previewBytes -= bytesOf(oldest->preview);
+                    previews.erase(oldest);
+                }
+            }
+
+            decoding.erase(key);
+        }
+
+        decoded.set_value(preview);
+        return preview;
+    }
+
+    // The cached Preview for file, if it has been decoded; never decodes
+    Preview findPreview(const juce::File& file)
+    {
+        const juce::ScopedLock lock(previewLock);
+
+        for (auto& entry : previews)
+        {
+            if (entry.file == file)
+            {
+                entry.lastUsed = ++useCounter;
+                return entry.preview;
+            }
+        }
+
+        return {};
+    }
+
+private:
+    static constexpr const char* defaultLibrary = "default";
+
+    // One library's vectors and paths, with the embeddings.bin size and
+    // time they were mapped at, so a rewrite by an unseen re-index shows
+    struct Shard
+    {
+        explicit Shard(const juce::File& dataDir)
+            : file(dataDir.getChildFile("embeddings.bin")),
+              bytes(file.getSize()),
+              modified(file.getLastModificationTime())
+        {
+            store.open(file);
+            paths.open(dataDir.getChildFile("paths.bin"));
+        }
+
+        bool isStale() const
+        {
+            return file.getSize() != bytes || file.getLastModificationTime() != modified;
+        }
+
+        juce::File file;
+        juce::int64 bytes;
+        juce::Time modified;
+        EmbeddingStore store;
+        PathTable paths;
+    };
+
+    struct CachedResults
+    {
+        juce::String key;
+        juce::var response;
+        juce::uint64 lastUsed = 0;
+    };
+
+    struct CachedPreview
+    {
+        juce::File file;
+        Preview preview;
+        juce::uint64 lastUsed = 0;
+    };
+
+    static juce::File statusFile()
+    {
+        return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+            .getChildFile("SoundSift").getChildFile("last_status.json");
+    }
+
+    // Maps the index and loads the encoder from the last saved /status.
+    // The IPC socket is left for the live /status: the server that wrote
+    // it may be gone.
+    void restoreStatus()
+    {
+        auto status = juce::JSON::parse(statusFile());
+
+        if (! status.hasProperty("data_dir"))
+            return;
+
+        openIndex(juce::File(status["data_dir"].toString()), juce::File(status["suggestions"].toString()),
+                  status["index_version"].toString(), status["stores"]);
+        openTextEncoder(status["text_encoder"]);
+    }
+
+    Preview decodePreview(const juce::File& file)
+    {
+        std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+
+        if (reader == nullptr || reader->sampleRate <= 0.0
+            || (double) reader->lengthInSamples > maxPreviewSeconds * reader->sampleRate)
+            return {};
+
+        Preview preview;
+        preview.sampleRate = reader->sampleRate;
+        // Mono files are read into both channels, as streaming them would
+        preview.buffer = std::make_shared<juce::AudioBuffer<float>>(juce::jmax(2, (int) reader->numChannels),
+                                                                    (int) reader->lengthInSamples);
+        reader->read(preview.buffer.get(), 0, (int) reader->lengthInSamples, 0, true, true);
+        return preview;
+    }
+
+    static size_t bytesOf(const Preview& preview)
+    {
+        return (size_t) preview.buffer->getNumChannels() * (size_t) preview.buffer->getNumSamples() * sizeof(float);
+    }
+
+    juce::CriticalSection indexLock;
+    juce::File openDataDir;
+    juce::String indexVersion;
+    std::shared_ptr<const Shard> defaultShard;
+    SuggestionIndex suggestions;
+    std::map<juce::String, std::unique_ptr<DescriptorTable>> descriptors;
+    std::map<juce::String, std::shared_ptr<const Shard>> shards;
+    std::vector<CachedResults> results;
+
+    juce::CriticalSection previewLock;
+    std::vector<CachedPreview> previews;
+    std::map<juce::String, std::shared_future<Preview>> decoding;
+    size_t previewBytes = 0;
+
+    std::atomic<juce::uint64> useCounter { 0 };
+
+    TextEncoder textEncoder;
+
+    JUCE_DECLARE_NON_COPYABLE(SharedCore)
+};
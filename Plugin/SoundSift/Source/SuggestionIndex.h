@@ -0,0 +1,150 @@
+#pragma once
+#include <JuceHeader.h>
+
+// Read-only view of the suggest.bin trie the backend builds from path
+// terms (Backend/src/suggest.py), queried on every keystroke without a
+// server round trip.
+//
+// Layout (little endian):
+//   char[4]  "SSTR"
+//   uint32   version
+//   uint32   node count
+//   char[4]  padding
+//   Node     nodes[count]   breadth-first, root first; each node's
+//                           children are contiguous and sorted by label
+class SuggestionIndex
+{
+public:
+    struct Node
+    {
+        juce::uint32 firstChild;
+        juce::uint16 childCount;
+        juce::uint8 label;
+        juce::uint8 flags;
+        juce::uint32 count;
+        juce::uint32 maxCount;  // highest count anywhere in this subtree
+    };
+
+    static_assert(sizeof(Node) == 16, "Node must match suggest.py's NODE_DTYPE");
+
+    SuggestionIndex() = default;
+    explicit SuggestionIndex(const juce::File& file) { open(file); }
+
+    bool open(const juce::File& file)
+    {
+        nodes = nullptr;
+        count = 0;
+        mapped = std::make_unique<juce::MemoryMappedFile>(file, juce::MemoryMappedFile::readOnly);
+
+        auto* data = static_cast<const char*>(mapped->getData());
+        auto size = mapped->getSize();
+
+        if (data == nullptr || size < headerBytes || std::memcmp(data, "SSTR", 4) != 0
+            || juce::ByteOrder::littleEndianInt(data + 4) != version)
+        {
+            mapped.reset();
+            return false;
+        }
+
+        auto n = (size_t) juce::ByteOrder::littleEndianInt(data + 8);
+
+        if (n == 0 || headerBytes + n * sizeof(Node) > size)
+        {
+            mapped.reset();
+            return false;
+        }
+
+        nodes = reinterpret_cast<const Node*>(data + headerBytes);
+        count = n;
+        return true;
+    }
+
+    bool isOpen() const { return mapped != nullptr; }
+
+    // Most frequent terms starting with prefix, best first
+    juce::StringArray complete(const juce::String& prefix, int maxResults) const
+    {
+        juce::StringArray results;
+
+        if (! isOpen() || maxResults <= 0)
+            return results;
+
+        auto key = prefix.toLowerCase().toStdString();
+        size_t node = 0;
+
+        for (auto c : key)
+        {
+            node = findChild(node, (juce::uint8) c);
+            if (node == notFound)
+                return results;
+        }
+
+        // Best-first over the subtree: entries are either a node still to
+        // expand (ranked by maxCount) or a finished term (ranked by count),
+        // so terms come off the queue in frequency order.
+        struct Entry
+        {
+            juce::uint32 rank;
+            size_t node;
+            bool expanded;
+            std::string term;
+
+            bool operator<(const Entry& other) const { return rank < other.rank; }
+        };
+
+        std::priority_queue<Entry> queue;
+        queue.push({ nodes[node].maxCount, node, false, key });
+
+        while (! queue.empty() && results.size() < maxResults)
+        {
+            auto entry = queue.top();
+            queue.pop();
+
+            if (entry.expanded)
+            {
+                if (entry.term != key)
+                    results.add(juce::String::fromUTF8(entry.term.data(), (int) entry.term.size()));
+                continue;
+            }
+
+            auto& n = nodes[entry.node];
+
+            if ((n.flags & terminal) != 0)
+                queue.push({ n.count, entry.node, true, entry.term });
+
+            for (size_t i = n.firstChild; i < (size_t) n.firstChild + n.childCount && i < count; ++i)
+                queue.push({ nodes[i].maxCount, i, false, entry.term + (char) nodes[i].label });
+        }
+
+        return results;
+    }
+
+private:
+    static constexpr size_t headerBytes = 16;
+    static constexpr juce::uint32 version = 1;
+    static constexpr juce::uint8 terminal = 1;
+    static constexpr size_t notFound = std::numeric_limits<size_t>::max();
+
+    size_t findChild(size_t parent, juce::uint8 label) const
+    {
+        auto& p = nodes[parent];
+        size_t lo = p.firstChild;
+        size_t hi = juce::jmin((size_t) p.firstChild + p.childCount, count);
+
+        while (lo < hi)
+        {
+            auto mid = lo + (hi - lo) / 2;
+
+            if (nodes[mid].label < label)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+
+        return (lo < count && lo < (size_t) p.firstChild + p.childCount && nodes[lo].label == label) ? lo : notFound;
+    }
+
+    std::unique_ptr<juce::MemoryMappedFile> mapped;
+    const Node* nodes = nullptr;
+    size_t count = 0;
+};
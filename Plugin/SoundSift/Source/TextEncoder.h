@@ -0,0 +1,606 @@
+#pragma once
+#include <JuceHeader.h>
+#include <unordered_map>
+
+// ONNX Runtime is an optional dependency: define SOUNDSIFT_USE_ONNXRUNTIME=1
+// and add its include and library paths to the exporter to get in-process
+// query encoding. Without it TextEncoder never opens and every search goes
+// to the backend, as before.
+#ifndef SOUNDSIFT_USE_ONNXRUNTIME
+ #define SOUNDSIFT_USE_ONNXRUNTIME 0
+#endif
+
+#if SOUNDSIFT_USE_ONNXRUNTIME
+ #include <onnxruntime_cxx_api.h>
+#endif
+
+// Byte-level BPE as RoBERTa (and so the CLAP text tower) tokenises: the
+// GPT-2 pre-tokeniser split, every UTF-8 byte mapped to a printable
+// symbol, then merges applied lowest rank first. Reads the vocab.json and
+// merges.txt that export_text_encoder.py saves next to the model. Ids
+// exclude the bos/eos markers; TextEncoder adds those.
+class BpeTokenizer
+{
+public:
+    static constexpr int maxCachedWords = 8192;
+
+    bool load(const juce::File& vocabFile, const juce::File& mergesFile, int unknownId)
+    {
+        vocab.clear();
+        ranks.clear();
+        unk = unknownId;
+
+        auto parsed = juce::JSON::parse(vocabFile);
+
+        if (auto* entries = parsed.getDynamicObject())
+            for (auto& entry : entries->getProperties())
+                vocab[entry.name.toString().toStdString()] = (int) entry.value;
+
+        // "#version: 0.2" header, then one "left right" pair per line,
+        // highest priority first
+        juce::StringArray lines;
+        mergesFile.readLines(lines);
+
+        for (auto& line : lines)
+            if (! line.startsWith("#version") && line.trim().containsChar(' '))
+                ranks.emplace(line.trim().toStdString(), (int) ranks.size());
+
+        for (int b = 0; b < 256; ++b)
+            byteSymbols[(size_t) b] = toUtf8(symbolForByte(b));
+
+        const juce::ScopedLock lock(cacheLock);
+        words.clear();
+
+        return ! vocab.empty() && ! ranks.empty();
+    }
+
+    bool isLoaded() const { return ! vocab.empty(); }
+
+    std::vector<int> encode(const juce::String& text) const
+    {
+        std::vector<int> ids;
+
+        for (auto& word : splitWords(text))
+        {
+            auto wordIds = encodeWord(word);
+            ids.insert(ids.end(), wordIds.begin(), wordIds.end());
+        }
+
+        return ids;
+    }
+
+    // The GPT-2 pre-tokeniser pattern, by hand:
+    //   's|'t|'re|'ve|'m|'ll|'d| ?\p{L}+| ?\p{N}+| ?[^\s\p{L}\p{N}]+|\s+(?!\S)|\s+
+    // Words come back as UTF-8; a leading space stays part of the word.
+    static std::vector<std::string> splitWords(const juce::String& text)
+    {
+        std::vector<juce::juce_wchar> chars;
+        for (auto p = text.getCharPointer(); ! p.isEmpty();)
+            chars.push_back(p.getAndAdvance());
+
+        auto n = chars.size();
+        std::vector<std::string> words;
+
+        auto isLetter = [](juce::juce_wchar c) { return classify(c) == CharClass::letter; };
+        auto isDigit = [](juce::juce_wchar c) { return classify(c) == CharClass::digit; };
+        auto isSpace = [](juce::juce_wchar c) { return classify(c) == CharClass::space; };
+        auto isOther = [](juce::juce_wchar c) { return classify(c) == CharClass::other; };
+
+        auto emit = [&](size_t begin, size_t end)
+        {
+            std::string word;
+            for (auto i = begin; i < end; ++i)
+                word += toUtf8(chars[i]);
+            words.push_back(std::move(word));
+        };
+
+        auto matchesAt = [&](size_t at, const char* suffix)
+        {
+            for (; *suffix != 0; ++suffix, ++at)
+                if (at >= n || chars[at] != (juce::juce_wchar) *suffix)
+                    return false;
+            return true;
+        };
+
+        size_t i = 0;
+
+        while (i < n)
+        {
+            if (chars[i] == '\'')
+            {
+                bool contraction = false;
+
+                for (auto* suffix : { "s", "t", "re", "ve", "m", "ll", "d" })
+                {
+                    if (matchesAt(i + 1, suffix))
+                    {
+                        auto end = i + 1 + std::strlen(suffix);
+                        emit(i, end);
+                        i = end;
+                        contraction = true;
+                        break;
+                    }
+                }
+
+                if (contraction)
+                    continue;
+            }
+
+            auto start = i;
+            auto j = (chars[i] == ' ' && i + 1 < n) ? i + 1 : i;
+
+            if (isLetter(chars[j]) || isDigit(chars[j]) || isOther(chars[j]))
+            {
+                auto letter = isLetter(chars[j]);
+                auto digit = isDigit(chars[j]);
+                auto k = j + 1;
+
+                while (k < n && (letter ? isLetter(chars[k]) : digit ? isDigit(chars[k]) : isOther(chars[k])))
+                    ++k;
+
+                emit(start, k);
+                i = k;
+                continue;
+            }
+
+            // Whitespace: a run followed by a word leaves its last
+            // character to that word, as \s+(?!\S) backtracks
+            auto k = i;
+            while (k < n && isSpace(chars[k]))
+                ++k;
+
+            if (k < n && k - i > 1)
+                --k;
+
+            emit(i, k);
+            i = k;
+        }
+
+        return words;
+    }
+
+private:
+    enum class CharClass { letter, digit, space, other };
+
+    // \p{L}, \p{N} and \s without a Unicode table (iswalpha and friends
+    // only know ASCII in the C locale): exact for Latin-1, and above it
+    // the common punctuation, symbol and emoji blocks are "other" and
+    // everything else is a letter, which covers the scripts queries use.
+    static CharClass classify(juce::juce_wchar c)
+    {
+        auto in = [c](juce::juce_wchar lo, juce::juce_wchar hi) { return c >= lo && c <= hi; };
+
+        if (in(9, 13) || c == ' ' || c == 0x85 || c == 0xa0 || c == 0x1680 || in(0x2000, 0x200a)
+            || c == 0x2028 || c == 0x2029 || c == 0x202f || c == 0x205f || c == 0x3000)
+            return CharClass::space;
+
+        if (c < 0x80)
+            return in('0', '9') ? CharClass::digit
+                 : (in('a', 'z') || in('A', 'Z')) ? CharClass::letter : CharClass::other;
+
+        if (c < 0x100)
+        {
+            if (c == 0xb2 || c == 0xb3 || c == 0xb9 || in(0xbc, 0xbe))
+                return CharClass::digit;
+
+            return (c == 0xaa || c == 0xb5 || c == 0xba || (c >= 0xc0 && c != 0xd7 && c != 0xf7))
+                       ? CharClass::letter : CharClass::other;
+        }
+
+        if (in(0x660, 0x669) || in(0x6f0, 0x6f9) || in(0x966, 0x96f) || in(0xff10, 0xff19))
+            return CharClass::digit;
+
+        if (in(0x2000, 0x206f) || in(0x20a0, 0x20cf) || in(0x2190, 0x23ff) || in(0x2500, 0x27bf)
+            || in(0x2900, 0x2bff) || in(0x3000, 0x303f) || in(0xfe30, 0xfe4f) || in(0xff01, 0xff0f)
+            || in(0xff1a, 0xff20) || in(0xff3b, 0xff40) || in(0xff5b, 0xff65) || in(0x1f000, 0x1faff))
+            return CharClass::other;
+
+        return CharClass::letter;
+    }
+
+    // GPT-2's bytes_to_unicode: printable Latin-1 bytes stand for
+    // themselves, the rest are shifted past 255
+    static juce::juce_wchar symbolForByte(int b)
+    {
+        auto printable = [](int c) { return (c >= 33 && c <= 126) || (c >= 161 && c <= 172) || (c >= 174 && c <= 255); };
+
+        if (printable(b))
+            return (juce::juce_wchar) b;
+
+        int shifted = 0;
+        for (int c = 0; c < b; ++c)
+            if (! printable(c))
+                ++shifted;
+
+        return (juce::juce_wchar) (256 + shifted);
+    }
+
+    static std::string toUtf8(juce::juce_wchar c)
+    {
+        char buffer[8] = {};
+        juce::CharPointer_UTF8(buffer).write(c);
+        return buffer;
+    }
+
+    std::vector<int> encodeWord(const std::string& word) const
+    {
+        {
+            const juce::ScopedLock lock(cacheLock);
+            auto cached = words.find(word);
+            if (cached != words.end())
+                return cached->second;
+        }
+
+        std::vector<std::string> parts;
+        for (auto byte : word)
+            parts.push_back(byteSymbols[(size_t) (unsigned char) byte]);
+
+        while (parts.size() > 1)
+        {
+            auto best = std::numeric_limits<int>::max();
+            size_t at = 0;
+
+            for (size_t i = 0; i + 1 < parts.size(); ++i)
+            {
+                auto rank = ranks.find(parts[i] + " " + parts[i + 1]);
+                if (rank != ranks.end() && rank->second < best)
+                {
+                    best = rank->second;
+                    at = i;
+                }
+            }
+
+            if (best == std::numeric_limits<int>::max())
+                break;
+
+            parts[at] += parts[at + 1];
+            parts.erase(parts.begin() + (std::ptrdiff_t) at + 1);
+        }
+
+        std::vector<int> ids;
+        for (auto& part : parts)
+        {
+            auto id = vocab.find(part);
+            ids.push_back(id != vocab.end() ? id->second : unk);
+        }
+
+        const juce::ScopedLock lock(cacheLock);
+        if ((int) words.size() >= maxCachedWords)
+            words.clear();
+        words[word] = ids;
+
+        return ids;
+    }
+
+    std::unordered_map<std::string, int> vocab;
+    std::unordered_map<std::string, int> ranks;
+    std::array<std::string, 256> byteSymbols;
+    int unk = 3;
+
+    juce::CriticalSection cacheLock;
+    mutable std::unordered_map<std::string, std::vector<int>> words;
+};
+
+// Runs the CLAP text tower exported by export_text_encoder.py in process,
+// so a text query costs a tokenise and one small int8 CPU inference rather
+// than a round trip to the server. The directory holds encoder.json, the
+// model and the tokenizer files.
+//
+// Thread-safe: open() swaps the model under a lock and encodes already
+// running finish on the one they started with. Recent query vectors are
+// kept, so repeating a search skips inference altogether.
+class TextEncoder
+{
+public:
+    using Vector = std::vector<float>;
+
+    static constexpr int dim = 512;
+    static constexpr int manifestVersion = 2;
+    static constexpr int maxBatch = 32;
+    static constexpr int maxCachedQueries = 256;
+
+    static bool isCompiledIn() { return SOUNDSIFT_USE_ONNXRUNTIME != 0; }
+
+    // Loads the model in directory unless it is already the open one.
+    // Slow the first time (hundreds of ms), so keep it off the message
+    // thread; fails if ONNX Runtime isn't compiled in.
+    bool open(const juce::File& directory)
+    {
+        {
+            const juce::ScopedLock lock(modelLock);
+            if (model != nullptr && directory == openDirectory)
+                return true;
+        }
+
+        auto loaded = load(directory);
+
+        const juce::ScopedLock lock(modelLock);
+        model = loaded;
+        openDirectory = loaded != nullptr ? directory : juce::File();
+        queries.clear();
+
+        return model != nullptr;
+    }
+
+    bool isOpen() const
+    {
+        const juce::ScopedLock lock(modelLock);
+        return model != nullptr;
+    }
+
+    juce::File getDirectory() const
+    {
+        const juce::ScopedLock lock(modelLock);
+        return openDirectory;
+    }
+
+    // One unit vector of dim floats per text, in order; empty when no
+    // model is open or inference failed. Uncached texts go through the
+    // model maxBatch at a time, sorted by length so little is padding.
+    std::vector<Vector> encodeBatch(const juce::StringArray& texts)
+    {
+        std::shared_ptr<Model> current;
+        std::vector<Vector> vectors((size_t) texts.size());
+        std::vector<int> missing;
+
+        {
+            const juce::ScopedLock lock(modelLock);
+            current = model;
+
+            for (int i = 0; i < texts.size(); ++i)
+                if (! findQuery(texts[i], vectors[(size_t) i]))
+                    missing.push_back(i);
+        }
+
+        if (current == nullptr)
+            return {};
+
+        std::vector<std::vector<juce::int64>> tokens((size_t) texts.size());
+        for (auto i : missing)
+            tokens[(size_t) i] = current->tokenize(texts[i]);
+
+        std::stable_sort(missing.begin(), missing.end(),
+                         [&tokens](int a, int b) { return tokens[(size_t) a].size() < tokens[(size_t) b].size(); });
+
+        for (size_t begin = 0; begin < missing.size(); begin += maxBatch)
+        {
+            std::vector<int> batch(missing.begin() + (std::ptrdiff_t) begin,
+                                   missing.begin() + (std::ptrdiff_t) juce::jmin(begin + maxBatch, missing.size()));
+
+            if (! current->run(tokens, batch, vectors))
+                return {};
+        }
+
+        const juce::ScopedLock lock(modelLock);
+
+        // A re-open while this ran leaves its vectors out of the new cache
+        if (current == model)
+            for (auto i : missing)
+                addQuery(texts[i], vectors[(size_t) i]);
+
+        return vectors;
+    }
+
+    Vector encode(const juce::String& text)
+    {
+        auto vectors = encodeBatch(juce::StringArray(text));
+        return vectors.empty() ? Vector() : std::move(vectors.front());
+    }
+
+private:
+    struct Model
+    {
+        BpeTokenizer tokenizer;
+        juce::int64 bos = 0, eos = 2, pad = 1;
+        int maxLength = 77;
+
+       #if SOUNDSIFT_USE_ONNXRUNTIME
+        std::unique_ptr<Ort::Session> session;
+       #endif
+
+        // <s> ids </s>, cut to the length the model was trained on
+        std::vector<juce::int64> tokenize(const juce::String& text) const
+        {
+            auto ids = tokenizer.encode(text);
+            ids.resize(juce::jmin(ids.size(), (size_t) (maxLength - 2)));
+
+            std::vector<juce::int64> tokens;
+            tokens.reserve(ids.size() + 2);
+            tokens.push_back(bos);
+            tokens.insert(tokens.end(), ids.begin(), ids.end());
+            tokens.push_back(eos);
+            return tokens;
+        }
+
+        // Pads the batch to its longest sequence; masked positions don't
+        // change the pooled output, so there's no need to go to maxLength
+        bool run(const std::vector<std::vector<juce::int64>>& tokens, const std::vector<int>& batch,
+                 std::vector<Vector>& vectors) const
+        {
+           #if SOUNDSIFT_USE_ONNXRUNTIME
+            size_t length = 0;
+            for (auto i : batch)
+                length = juce::jmax(length, tokens[(size_t) i].size());
+
+            std::vector<int64_t> ids(batch.size() * length, (int64_t) pad);
+            std::vector<int64_t> mask(batch.size() * length, 0);
+
+            for (size_t row = 0; row < batch.size(); ++row)
+            {
+                auto& sequence = tokens[(size_t) batch[row]];
+                std::copy(sequence.begin(), sequence.end(), ids.begin() + (std::ptrdiff_t) (row * length));
+                std::fill_n(mask.begin() + (std::ptrdiff_t) (row * length), sequence.size(), (int64_t) 1);
+            }
+
+            std::array<int64_t, 2> shape { (int64_t) batch.size(), (int64_t) length };
+            static const char* inputNames[] = { "input_ids", "attention_mask" };
+            static const char* outputNames[] = { "embedding" };
+
+            try
+            {
+                auto memory = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+                std::vector<Ort::Value> inputs;
+                inputs.push_back(Ort::Value::CreateTensor<int64_t>(memory, ids.data(), ids.size(), shape.data(), shape.size()));
+                inputs.push_back(Ort::Value::CreateTensor<int64_t>(memory, mask.data(), mask.size(), shape.data(), shape.size()));
+
+                // Session::Run is safe to call from several threads at once
+                auto outputs = session->Run(Ort::RunOptions { nullptr }, inputNames, inputs.data(), inputs.size(),
+                                            outputNames, 1);
+
+                auto outputShape = outputs.front().GetTensorTypeAndShapeInfo().GetShape();
+                if (outputShape.size() != 2 || outputShape[0] != (int64_t) batch.size() || outputShape[1] != dim)
+                    return false;
+
+                auto* data = outputs.front().GetTensorData<float>();
+                for (size_t row = 0; row < batch.size(); ++row)
+                    vectors[(size_t) batch[row]].assign(data + row * dim, data + (row + 1) * dim);
+
+                return true;
+            }
+            catch (const Ort::Exception& e)
+            {
+                DBG("TextEncoder: " << e.what());
+                return false;
+            }
+           #else
+            juce::ignoreUnused(tokens, batch, vectors);
+            return false;
+           #endif
+        }
+    };
+
+    struct CachedQuery
+    {
+        juce::String text;
+        Vector vector;
+        juce::uint64 lastUsed = 0;
+    };
+
+    static std::shared_ptr<Model> load(const juce::File& directory)
+    {
+       #if SOUNDSIFT_USE_ONNXRUNTIME
+        auto manifest = juce::JSON::parse(directory.getChildFile("encoder.json"));
+
+        if (! manifest.isObject() || (int) manifest["version"] != manifestVersion || (int) manifest["dim"] != dim)
+            return {};
+
+        auto loaded = std::make_shared<Model>();
+        loaded->bos = (int) manifest.getProperty("bos_id", 0);
+        loaded->pad = (int) manifest.getProperty("pad_id", 1);
+        loaded->eos = (int) manifest.getProperty("eos_id", 2);
+        loaded->maxLength = juce::jmax(3, (int) manifest.getProperty("max_length", 77));
+
+        if (! loaded->tokenizer.load(directory.getChildFile(manifest["vocab"].toString()),
+                                     directory.getChildFile(manifest["merges"].toString()),
+                                     (int) manifest.getProperty("unk_id", 3)))
+            return {};
+
+        // The embeddings are only clap's if the ids are: a tokenizer that
+        // splits one query differently would quietly skew every search
+        if (! tokenizesLike(*loaded, manifest["token_checks"]))
+            return {};
+
+        auto modelFile = directory.getChildFile(manifest["model"].toString());
+
+        try
+        {
+            // Queries come one at a time from the UI, so a few intra-op
+            // threads cut latency; more just compete with the audio thread
+            Ort::SessionOptions options;
+            options.SetIntraOpNumThreads(juce::jlimit(1, 4, juce::SystemStats::getNumCpus() / 2));
+            options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
+
+           #if JUCE_WINDOWS
+            loaded->session = std::make_unique<Ort::Session>(environment(), modelFile.getFullPathName().toWideCharPointer(), options);
+           #else
+            loaded->session = std::make_unique<Ort::Session>(environment(), modelFile.getFullPathName().toRawUTF8(), options);
+           #endif
+        }
+        catch (const Ort::Exception& e)
+        {
+            DBG("TextEncoder: " << e.what());
+            return {};
+        }
+
+        return loaded;
+       #else
+        juce::ignoreUnused(directory);
+        return {};
+       #endif
+    }
+
+    // True when model tokenizes every encoder.json "token_checks" entry
+    // ({"text", "ids"}) to exactly its ids; a manifest without any fails
+    static bool tokenizesLike(const Model& model, const juce::var& checks)
+    {
+        auto* entries = checks.getArray();
+
+        if (entries == nullptr || entries->isEmpty())
+            return false;
+
+        for (auto& check : *entries)
+        {
+            auto* expected = check["ids"].getArray();
+            auto tokens = model.tokenize(check["text"].toString());
+
+            if (expected == nullptr || (size_t) expected->size() != tokens.size())
+                return false;
+
+            for (size_t i = 0; i < tokens.size(); ++i)
+                if ((juce::int64) (*expected)[(int) i] != tokens[i])
+                {
+                    DBG("TextEncoder: tokenizer disagrees with clap on \"" << check["text"].toString() << "\"");
+                    return false;
+                }
+        }
+
+        return true;
+    }
+
+   #if SOUNDSIFT_USE_ONNXRUNTIME
+    // One per process, outliving every session
+    static Ort::Env& environment()
+    {
+        static Ort::Env env(ORT_LOGGING_LEVEL_WARNING, "SoundSift");
+        return env;
+    }
+   #endif
+
+    // Both called with modelLock held
+    bool findQuery(const juce::String& text, Vector& vector)
+    {
+        for (auto& entry : queries)
+        {
+            if (entry.text == text)
+            {
+                entry.lastUsed = ++useCounter;
+                vector = entry.vector;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void addQuery(const juce::String& text, const Vector& vector)
+    {
+        for (auto& entry : queries)
+            if (entry.text == text)
+                return;
+
+        if ((int) queries.size() >= maxCachedQueries)
+        {
+            auto oldest = std::min_element(queries.begin(), queries.end(),
+                                           [](auto& a, auto& b) { return a.lastUsed < b.lastUsed; });
+            queries.erase(oldest);
+        }
+
+        queries.push_back({ text, vector, ++useCounter });
+    }
+
+    juce::CriticalSection modelLock;
+    std::shared_ptr<Model> model;
+    juce::File openDirectory;
+    std::vector<CachedQuery> queries;
+    juce::uint64 useCounter = 0;
+};
@@ -0,0 +1,357 @@
+#include <JuceHeader.h>
+#include <iostream>
+#include "../../SoundSift/Source/ApiClient.h"
+#include "../../SoundSift/Source/EmbeddingStore.h"
+#include "../../SoundSift/Source/PathTable.h"
+
+// Search micro-benchmarks over synthetic stores in the backend's
+// embeddings.bin / paths.bin format. Results go to stdout as a table and
+// to --out as JSON so runs can be diffed between releases.
+//
+//   SoundSiftBench [--rows=10000,100000,1000000] [--queries=32]
+//                  [--dir=<store cache>] [--out=soundsift_bench.json]
+//
+// Generated stores are cached in --dir and reused on the next run.
+
+namespace
+{
+    double secondsSince(juce::int64 startTicks)
+    {
+        return juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+    }
+
+    struct Timings
+    {
+        std::vector<double> seconds;
+
+        template <typename Fn>
+        void run(int iterations, Fn&& fn)
+        {
+            for (int i = 0; i < iterations; ++i)
+            {
+                auto start = juce::Time::getHighResolutionTicks();
+                fn(i);
+                seconds.push_back(secondsSince(start));
+            }
+        }
+
+        double percentile(double p) const
+        {
+            if (seconds.empty())
+                return 0.0;
+
+            auto sorted = seconds;
+            std::sort(sorted.begin(), sorted.end());
+            auto index = (size_t) juce::jlimit(0.0, (double) sorted.size() - 1, p * (double) (sorted.size() - 1) + 0.5);
+            return sorted[index];
+        }
+
+        double mean() const
+        {
+            double total = 0.0;
+            for (auto s : seconds)
+                total += s;
+            return seconds.empty() ? 0.0 : total / (double) seconds.size();
+        }
+    };
+
+    void randomUnitVector(juce::Random& rng, float* v)
+    {
+        double norm = 0.0;
+
+        for (int i = 0; i < EmbeddingStore::dim; ++i)
+        {
+            v[i] = rng.nextFloat() * 2.0f - 1.0f;
+            norm += (double) v[i] * v[i];
+        }
+
+        auto scale = (float) (1.0 / std::sqrt(juce::jmax(norm, 1.0e-12)));
+        juce::FloatVectorOperations::multiply(v, scale, EmbeddingStore::dim);
+    }
+
+    juce::String syntheticPath(int index)
+    {
+        return "/Samples/Vendor " + juce::String(index % 37)
+             + "/Kit " + juce::String(index % 101)
+             + "/Synthetic_Sample_" + juce::String(index) + ".wav";
+    }
+
+    bool writeEmbeddings(const juce::File& file, int rows, juce::Random& rng)
+    {
+        file.deleteFile();
+        juce::FileOutputStream out(file);
+
+        if (out.failedToOpen())
+            return false;
+
+        std::vector<float> row(EmbeddingStore::dim);
+
+        for (int i = 0; i < rows; ++i)
+        {
+            randomUnitVector(rng, row.data());
+            out.write(row.data(), EmbeddingStore::rowBytes());
+        }
+
+        return out.getStatus().wasOk();
+    }
+
+    // Same layout the backend's write_path_table produces
+    bool writePathTable(const juce::File& file, int rows)
+    {
+        file.deleteFile();
+        juce::FileOutputStream out(file);
+
+        if (out.failedToOpen())
+            return false;
+
+        juce::MemoryOutputStream blob;
+        std::vector<juce::uint64> offsets { 0 };
+        offsets.reserve((size_t) rows + 1);
+
+        for (int i = 0; i < rows; ++i)
+        {
+            blob << syntheticPath(i);
+            offsets.push_back((juce::uint64) blob.getDataSize());
+        }
+
+        out.write("SSPT", 4);
+        out.writeInt(rows);
+        for (auto offset : offsets)
+            out.writeInt64((juce::int64) offset);
+        out.write(blob.getData(), blob.getDataSize());
+
+        return out.getStatus().wasOk();
+    }
+
+    // Body of a /query/text response as the server sends it
+    juce::String syntheticResponse(int topK, juce::Random& rng)
+    {
+        juce::Array<juce::var> results;
+
+        for (int i = 0; i < topK; ++i)
+        {
+            juce::DynamicObject::Ptr hit = new juce::DynamicObject();
+            hit->setProperty("library", "default");
+            hit->setProperty("id", rng.nextInt(100000));
+            hit->setProperty("score", 1.0 - i * 0.01);
+            hit->setProperty("path", syntheticPath(rng.nextInt(100000)));
+            results.add(juce::var(hit.get()));
+        }
+
+        juce::DynamicObject::Ptr response = new juce::DynamicObject();
+        response->setProperty("results", results);
+        return juce::JSON::toString(juce::var(response.get()), true);
+    }
+
+    class Report
+    {
+    public:
+        void add(const juce::String& name, int rows, juce::NamedValueSet metrics)
+        {
+            juce::DynamicObject::Ptr entry = new juce::DynamicObject();
+            entry->setProperty("name", name);
+            entry->setProperty("rows", rows);
+
+            juce::String line = name.paddedRight(' ', 14) + juce::String(rows).paddedLeft(' ', 9);
+
+            for (auto& metric : metrics)
+            {
+                entry->setProperty(metric.name, metric.value);
+                line << "  " << metric.name.toString() << "=" << juce::String((double) metric.value, 3);
+            }
+
+            std::cout << line << std::endl;
+            entries.add(juce::var(entry.get()));
+        }
+
+        bool write(const juce::File& file) const
+        {
+            juce::DynamicObject::Ptr root = new juce::DynamicObject();
+            root->setProperty("version", ProjectInfo::versionString);
+            root->setProperty("date", juce::Time::getCurrentTime().toISO8601(true));
+            root->setProperty("cpu", juce::SystemStats::getCpuModel());
+            root->setProperty("cores", juce::SystemStats::getNumCpus());
+            root->setProperty("os", juce::SystemStats::getOperatingSystemName());
+            root->setProperty("dim", EmbeddingStore::dim);
+            root->setProperty("results", entries);
+
+            return file.replaceWithText(juce::JSON::toString(juce::var(root.get())));
+        }
+
+    private:
+        juce::Array<juce::var> entries;
+    };
+
+    void benchmarkStore(const juce::File& dir, int rows, int queries, Report& report)
+    {
+        juce::Random rng(rows);
+        auto embeddingsFile = dir.getChildFile("embeddings_" + juce::String(rows) + ".bin");
+        auto pathsFile = dir.getChildFile("paths_" + juce::String(rows) + ".bin");
+
+        // Each cached file is reused only if it still matches rows; a run
+        // interrupted between the two, or an older layout, regenerates it
+        if (embeddingsFile.getSize() != (juce::int64) rows * (juce::int64) EmbeddingStore::rowBytes())
+        {
+            std::cout << "generating " << rows << " rows..." << std::endl;
+
+            if (! writeEmbeddings(embeddingsFile, rows, rng))
+            {
+                std::cerr << "failed to write synthetic embeddings in " << dir.getFullPathName() << std::endl;
+                return;
+            }
+        }
+
+        // Checked in its own scope: the mapping must be gone before a rewrite
+        auto pathsCurrent = [&]
+        {
+            PathTable cached(pathsFile);
+            return cached.isOpen() && cached.size() == rows;
+        };
+
+        if (! pathsCurrent())
+        {
+            std::cout << "generating " << rows << " paths..." << std::endl;
+
+            if (! writePathTable(pathsFile, rows))
+            {
+                std::cerr << "failed to write synthetic paths in " << dir.getFullPathName() << std::endl;
+                return;
+            }
+        }
+
+        EmbeddingStore store(embeddingsFile);
+        PathTable paths(pathsFile);
+
+        if (! store.isOpen() || ! paths.isOpen() || store.size() != rows)
+        {
+            std::cerr << "failed to open synthetic store for " << rows << " rows" << std::endl;
+            return;
+        }
+
+        std::vector<std::vector<float>> queryVectors((size_t) queries, std::vector<float>(EmbeddingStore::dim));
+        for (auto& q : queryVectors)
+            randomUnitVector(rng, q.data());
+
+        std::vector<float> scores((size_t) rows);
+        auto gigabytes = (double) store.sizeInBytes() / 1.0e9;
+
+        // Untimed pass so every run measures a warm page cache
+        store.scoreRows(queryVectors[0].data(), 0, rows, scores.data());
+
+        Timings scan;
+        scan.run(queries, [&](int i) { store.scoreRows(queryVectors[(size_t) i].data(), 0, rows, scores.data()); });
+
+        juce::NamedValueSet scanMetrics;
+        scanMetrics.set("p50_ms", scan.percentile(0.5) * 1000.0);
+        scanMetrics.set("p99_ms", scan.percentile(0.99) * 1000.0);
+        scanMetrics.set("gb_per_s", gigabytes / scan.percentile(0.5));
+        report.add("scan", rows, scanMetrics);
+
+        for (int k : { 10, 50 })
+        {
+            size_t selected = 0;
+            Timings select;
+            select.run(queries, [&](int) { selected += EmbeddingStore::selectTopK(scores.data(), rows, k).size(); });
+            jassert(selected == (size_t) (queries * juce::jmin(k, rows)));
+
+            juce::NamedValueSet selectMetrics;
+            selectMetrics.set("k", k);
+            selectMetrics.set("p50_ms", select.percentile(0.5) * 1000.0);
+            selectMetrics.set("ns_per_row", select.percentile(0.5) * 1.0e9 / rows);
+            report.add("topk", rows, selectMetrics);
+        }
+
+        std::vector<EmbeddingStore::Hit> hits;
+        Timings search;
+        search.run(queries, [&](int i) { hits = store.search(queryVectors[(size_t) i].data(), 10); });
+
+        juce::NamedValueSet searchMetrics;
+        searchMetrics.set("p50_ms", search.percentile(0.5) * 1000.0);
+        searchMetrics.set("p99_ms", search.percentile(0.99) * 1000.0);
+        searchMetrics.set("queries_per_s", 1.0 / search.mean());
+        report.add("search_top10", rows, searchMetrics);
+
+        const int lookups = 10000;
+        std::vector<int> ids((size_t) lookups);
+        for (auto& id : ids)
+            id = rng.nextInt(rows);
+
+        size_t totalChars = 0;
+        Timings resolve;
+        resolve.run(1, [&](int)
+        {
+            for (auto id : ids)
+                totalChars += (size_t) paths[id].length();
+        });
+
+        juce::NamedValueSet resolveMetrics;
+        resolveMetrics.set("ns_per_lookup", resolve.mean() * 1.0e9 / lookups);
+        resolveMetrics.set("chars", (juce::int64) totalChars);
+        report.add("resolve_path", rows, resolveMetrics);
+    }
+
+    void benchmarkDecode(int iterations, Report& report)
+    {
+        juce::Random rng(42);
+
+        for (int topK : { 10, 50 })
+        {
+            auto body = syntheticResponse(topK, rng);
+            int decoded = 0;
+
+            Timings decode;
+            decode.run(iterations, [&](int)
+            {
+                juce::var parsed;
+                juce::JSON::parse(body, parsed);
+                decoded += ApiClient::decodeResults(parsed).size();
+            });
+
+            juce::NamedValueSet metrics;
+            metrics.set("k", topK);
+            metrics.set("bytes", (int) body.getNumBytesAsUTF8());
+            metrics.set("p50_us", decode.percentile(0.5) * 1.0e6);
+            metrics.set("p99_us", decode.percentile(0.99) * 1.0e6);
+            report.add("decode_json", decoded / iterations, metrics);
+        }
+    }
+}
+
+int main (int argc, char* argv[])
+{
+    juce::ArgumentList args(argc, argv);
+
+    auto rowsOption = args.containsOption("--rows") ? args.getValueForOption("--rows")
+                                                    : juce::String("10000,100000,1000000");
+    auto queries = juce::jmax(1, args.containsOption("--queries") ? args.getValueForOption("--queries").getIntValue() : 32);
+
+    auto dir = args.containsOption("--dir")
+                 ? juce::File::getCurrentWorkingDirectory().getChildFile(args.getValueForOption("--dir"))
+                 : juce::File::getSpecialLocation(juce::File::tempDirectory).getChildFile("SoundSiftBench");
+
+    auto out = juce::File::getCurrentWorkingDirectory().getChildFile(
+        args.containsOption("--out") ? args.getValueForOption("--out") : juce::String("soundsift_bench.json"));
+
+    if (! dir.createDirectory())
+    {
+        std::cerr << "cannot create " << dir.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    Report report;
+
+    for (auto& rows : juce::StringArray::fromTokens(rowsOption, ",", ""))
+        if (rows.getIntValue() > 0)
+            benchmarkStore(dir, rows.getIntValue(), queries, report);
+
+    benchmarkDecode(1000, report);
+
+    if (! report.write(out))
+    {
+        std::cerr << "cannot write " << out.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    std::cout << "wrote " << out.getFullPathName() << std::endl;
+    return 0;
+}
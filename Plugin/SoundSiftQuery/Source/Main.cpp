@@ -0,0 +1,355 @@
+#include <JuceHeader.h>
+#include <iostream>
+#include "../../SoundSift/Source/ApiClient.h"
+#include "../../SoundSift/Source/EmbeddingStore.h"
+#include "../../SoundSift/Source/PathTable.h"
+#include "../../SoundSift/Source/TextEncoder.h"
+
+// Runs text queries against the backend in bulk, for scripts such as
+// auto-tagging and kit generation. Queries are read one per line from a
+// file or stdin (blank lines and lines starting with # are skipped), sent
+// through ApiClient with at most --jobs requests in flight, and every hit
+// is streamed to stdout as it arrives:
+//
+//   tsv:   query <TAB> rank <TAB> score <TAB> path
+//   json:  {"query": ..., "rank": ..., "score": ..., "path": ..., "offset": ...}
+//
+// Lines come in completion order, ranks from 1. Throughput and latency go
+// to stderr at the end, so stdout stays machine-readable.
+//
+//   SoundSiftQuery [queries.txt | -] [--url=http://localhost:8000] [--top-k=10]
+//                  [--jobs=8] [--format=tsv|json] [--filters=<QueryFilters json>] [--ipc]
+//                  [--local=<backend data dir>]
+//
+// --ipc sends queries over the backend's socket transport when /status
+// advertises it. A connection answers one request at a time, so it helps
+// latency rather than throughput; leave it off to size the HTTP server.
+//
+// --local needs no server: queries are encoded in batches with the text
+// encoder export_text_encoder.py wrote to <dir>/text_encoder and scanned
+// against <dir>/embeddings.bin. That is the default library's semantic
+// search only (no filters, lexical matches or segment offsets), and needs
+// a build with SOUNDSIFT_USE_ONNXRUNTIME=1.
+
+namespace
+{
+    struct Options
+    {
+        juce::String url = "http://localhost:8000";
+        int topK = 10;
+        int jobs = 8;
+        bool json = false;
+        bool ipc = false;
+        juce::String local;
+        juce::var filters;
+    };
+
+    juce::StringArray readQueries(const juce::String& source)
+    {
+        juce::StringArray lines;
+
+        if (source.isEmpty() || source == "-")
+        {
+            for (std::string line; std::getline(std::cin, line);)
+                lines.add(juce::String::fromUTF8(line.c_str()));
+        }
+        else
+        {
+            juce::File::getCurrentWorkingDirectory().getChildFile(source).readLines(lines);
+        }
+
+        juce::StringArray queries;
+        for (auto& line : lines)
+            if (line.trim().isNotEmpty() && ! line.trim().startsWithChar('#'))
+                queries.add(line.trim());
+
+        return queries;
+    }
+
+    // Tabs and newlines in a field would break the row
+    juce::String tsvField(const juce::String& text)
+    {
+        return text.replaceCharacters("\t\r\n", "   ");
+    }
+
+    void writeHit(const Options& options, const juce::String& query, int rank, const ApiClient::SearchResult& hit)
+    {
+        if (options.json)
+        {
+            juce::DynamicObject::Ptr line = new juce::DynamicObject();
+            line->setProperty("query", query);
+            line->setProperty("rank", rank);
+            line->setProperty("score", hit.score);
+            line->setProperty("path", hit.path);
+            line->setProperty("offset", hit.offset);
+            std::cout << juce::JSON::toString(juce::var(line.get()), true) << '\n';
+        }
+        else
+        {
+            std::cout << tsvField(query) << '\t' << rank << '\t'
+                      << juce::String(hit.score, 6) << '\t' << tsvField(hit.path) << '\n';
+        }
+    }
+
+    double percentileMs(std::vector<double> seconds, double p)
+    {
+        if (seconds.empty())
+            return 0.0;
+
+        std::sort(seconds.begin(), seconds.end());
+        auto index = (size_t) juce::jlimit(0.0, (double) seconds.size() - 1, p * (double) (seconds.size() - 1) + 0.5);
+        return seconds[index] * 1000.0;
+    }
+
+    class BatchRunner
+    {
+    public:
+        BatchRunner(ApiClient& c, juce::StringArray q, const Options& o)
+            : client(c), queries(std::move(q)), options(o) {}
+
+        void start()
+        {
+            startTicks = juce::Time::getHighResolutionTicks();
+
+            for (int i = 0; i < options.jobs; ++i)
+                issueNext();
+
+            if (queries.isEmpty())
+                finish();
+        }
+
+        int getFailures() const { return failures; }
+
+    private:
+        // Everything below runs on the message thread, where ApiClient
+        // delivers its callbacks, so the bookkeeping needs no locks
+        void issueNext()
+        {
+            if (next >= queries.size())
+                return;
+
+            auto index = next++;
+            auto issued = juce::Time::getHighResolutionTicks();
+
+            client.queryText(queries[index], options.topK, options.filters,
+                             [this, index, issued](bool success, juce::var response)
+            {
+                latencies.push_back(juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - issued));
+                completed(index, success, response);
+            });
+        }
+
+        void completed(int index, bool success, const juce::var& response)
+        {
+            auto& query = queries.getReference(index);
+
+            if (! success)
+            {
+                ++failures;
+                std::cerr << "query failed: " << query << std::endl;
+            }
+
+            auto results = ApiClient::decodeResults(response);
+
+            for (int rank = 0; rank < results.size(); ++rank)
+                writeHit(options, query, rank + 1, results.getReference(rank));
+
+            std::cout.flush();
+
+            if (++done == queries.size())
+                finish();
+            else
+                issueNext();
+        }
+
+        void finish()
+        {
+            auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+
+            std::cerr << done << " queries (" << failures << " failed) in " << juce::String(seconds, 3) << " s, "
+                      << juce::String(seconds > 0.0 ? done / seconds : 0.0, 1) << " queries/s with "
+                      << options.jobs << " in flight; latency p50 " << juce::String(percentileMs(latencies, 0.5), 1)
+                      << " ms / p99 " << juce::String(percentileMs(latencies, 0.99), 1) << " ms" << std::endl;
+
+            juce::MessageManager::getInstance()->stopDispatchLoop();
+        }
+
+        ApiClient& client;
+        juce::StringArray queries;
+        Options options;
+
+        int next = 0;
+        int done = 0;
+        int failures = 0;
+        juce::int64 startTicks = 0;
+        std::vector<double> latencies;
+    };
+
+    // Encodes queries chunk at a time (TextEncoder batches them further,
+    // by length) and scans each chunk's vectors across --jobs threads
+    int runLocal(const juce::StringArray& queries, const Options& options)
+    {
+        static constexpr int chunkSize = 256;
+
+        auto dataDir = juce::File::getCurrentWorkingDirectory().getChildFile(options.local);
+        TextEncoder encoder;
+        EmbeddingStore store;
+        PathTable paths;
+
+        if (! encoder.open(dataDir.getChildFile("text_encoder")))
+        {
+            std::cerr << (TextEncoder::isCompiledIn() ? "no text encoder in " + dataDir.getChildFile("text_encoder").getFullPathName()
+                                                          + " - run export_text_encoder.py"
+                                                      : juce::String("built without ONNX Runtime (SOUNDSIFT_USE_ONNXRUNTIME)"))
+                      << std::endl;
+            return 1;
+        }
+
+        if (! store.open(dataDir.getChildFile("embeddings.bin")) || ! paths.open(dataDir.getChildFile("paths.bin")))
+        {
+            std::cerr << "no index in " << dataDir.getFullPathName() << std::endl;
+            return 1;
+        }
+
+        juce::ThreadPool pool(options.jobs);
+        std::vector<double> scanSeconds((size_t) queries.size());
+        double encodeSeconds = 0.0;
+        auto startTicks = juce::Time::getHighResolutionTicks();
+
+        for (int begin = 0; begin < queries.size(); begin += chunkSize)
+        {
+            juce::StringArray chunk;
+            chunk.addArray(queries, begin, chunkSize);
+
+            auto encodeStart = juce::Time::getHighResolutionTicks();
+            auto vectors = encoder.encodeBatch(chunk);
+            encodeSeconds += juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - encodeStart);
+
+            if (vectors.empty())
+            {
+                std::cerr << "text encoder failed" << std::endl;
+                return 2;
+            }
+
+            std::vector<std::vector<EmbeddingStore::Hit>> hits((size_t) chunk.size());
+
+            for (int i = 0; i < chunk.size(); ++i)
+            {
+                pool.addJob([&, i]
+                {
+                    auto scanStart = juce::Time::getHighResolutionTicks();
+                    hits[(size_t) i] = store.search(vectors[(size_t) i].data(), options.topK);
+                    scanSeconds[(size_t) (begin + i)] = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - scanStart);
+                });
+            }
+
+            while (pool.getNumJobs() > 0)
+                juce::Thread::sleep(1);
+
+            for (int i = 0; i < chunk.size(); ++i)
+            {
+                for (size_t rank = 0; rank < hits[(size_t) i].size(); ++rank)
+                {
+                    ApiClient::SearchResult result;
+                    result.path = paths[hits[(size_t) i][rank].index];
+                    result.score = hits[(size_t) i][rank].score;
+                    writeHit(options, chunk[i], (int) rank + 1, result);
+                }
+            }
+
+            std::cout.flush();
+        }
+
+        auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+
+        std::cerr << queries.size() << " queries in " << juce::String(seconds, 3) << " s, "
+                  << juce::String(seconds > 0.0 ? queries.size() / seconds : 0.0, 1) << " queries/s locally; encode "
+                  << juce::String(queries.isEmpty() ? 0.0 : encodeSeconds * 1000.0 / queries.size(), 2)
+                  << " ms/query batched, scan p50 " << juce::String(percentileMs(scanSeconds, 0.5), 1)
+                  << " ms / p99 " << juce::String(percentileMs(scanSeconds, 0.99), 1) << " ms over "
+                  << store.size() << " vectors" << std::endl;
+
+        return 0;
+    }
+}
+
+int main (int argc, char* argv[])
+{
+    juce::ArgumentList args(argc, argv);
+    Options options;
+
+    if (args.containsOption("--url"))
+        options.url = args.getValueForOption("--url").trimCharactersAtEnd("/");
+    if (args.containsOption("--top-k"))
+        options.topK = juce::jmax(1, args.getValueForOption("--top-k").getIntValue());
+    if (args.containsOption("--jobs"))
+        options.jobs = juce::jlimit(1, 256, args.getValueForOption("--jobs").getIntValue());
+
+    options.json = args.getValueForOption("--format") == "json";
+    options.ipc = args.containsOption("--ipc");
+    options.local = args.getValueForOption("--local");
+
+    if (args.containsOption("--filters"))
+    {
+        options.filters = juce::JSON::parse(args.getValueForOption("--filters"));
+
+        if (! options.filters.isObject())
+        {
+            std::cerr << "--filters must be a JSON object, e.g. {\"max_duration\": 2}" << std::endl;
+            return 1;
+        }
+    }
+
+    juce::String source;
+    for (auto& arg : args.arguments)
+        if (! arg.isOption() || arg.text == "-")
+            source = arg.text;
+
+    auto queries = readQueries(source);
+
+    if (options.local.isNotEmpty())
+        return runLocal(queries, options);
+
+    // ApiClient delivers results through the message queue, which this
+    // thread runs until the batch is done
+    juce::MessageManager::getInstance();
+    int exitCode = 0;
+
+    {
+        juce::ThreadPool pool(options.jobs);
+        ApiClient client(options.url);
+        client.setWorkers(&pool);
+
+        BatchRunner runner(client, queries, options);
+
+        if (options.ipc)
+        {
+            // /status says where the transport listens; the batch starts
+            // once it has answered, connected or not
+            auto transport = std::make_shared<IpcTransport>();
+
+            client.getStatus([&client, &runner, transport](bool success, juce::var status)
+            {
+                auto description = status["ipc"];
+
+                if (success && description.isObject()
+                    && transport->connect(description["socket"].toString(), description["shm"].toString()))
+                    client.setIpc(transport);
+                else
+                    std::cerr << "IPC transport unavailable, using HTTP" << std::endl;
+
+                runner.start();
+            });
+        }
+        else
+        {
+            runner.start();
+        }
+
+        juce::MessageManager::getInstance()->runDispatchLoop();
+        exitCode = runner.getFailures() > 0 ? 2 : 0;
+    }
+
+    juce::MessageManager::deleteInstance();
+    return exitCode;
+}
@@ -0,0 +1,343 @@
+#include <JuceHeader.h>
+#include <iostream>
+#include <set>
+#include "../../SoundSift/Source/PluginProcessor.h"
+
+// Offline render harness for the playback path. Instantiates
+// SoundSiftAudioProcessor without a host, and for every sample rate and
+// block size prepares it, loads each file from the samples folder and
+// drives processBlock as fast as it will go until the preview ends.
+//
+// Every render is checked against a reference decode of the file made
+// with a separate format manager: sample-exact when the rate matches the
+// file's, RMS within rmsToleranceDb when the transport has to resample,
+// and in both cases no shorter than the file.
+// Per-block CPU cost, the worst block, and loadFile latency (cold, and
+// warm from the shared preview cache) are printed and written to --out.
+//
+//   SoundSiftRender [--samples=<dir>] [--rates=44100,48000,96000]
+//                   [--blocks=32,256,1024] [--files=0] [--out=soundsift_render.json]
+//
+// The exit status is 1 when any render fails its check, so it can gate CI.
+
+namespace
+{
+    constexpr float exactTolerance = 1.0e-5f;
+    constexpr double rmsToleranceDb = 0.5;
+
+    // The transport's resampler reads a few samples ahead, so it can see
+    // the end of the stream while the last of them are still buffered
+    constexpr int tailSlackSamples = 8;
+
+    double secondsSince(juce::int64 startTicks)
+    {
+        return juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+    }
+
+    double percentile(std::vector<double> values, double p)
+    {
+        if (values.empty())
+            return 0.0;
+
+        std::sort(values.begin(), values.end());
+        auto index = (size_t) juce::jlimit(0.0, (double) values.size() - 1, p * (double) (values.size() - 1) + 0.5);
+        return values[index];
+    }
+
+    juce::Array<int> parseList(const juce::ArgumentList& args, const juce::String& option, const juce::String& fallback)
+    {
+        juce::Array<int> values;
+        auto text = args.containsOption(option) ? args.getValueForOption(option) : fallback;
+
+        for (auto& token : juce::StringArray::fromTokens(text, ",", ""))
+            if (token.getIntValue() > 0)
+                values.add(token.getIntValue());
+
+        return values;
+    }
+
+    // Samples/ in the working directory or any parent, so the harness
+    // finds the repository's samples when run from a build folder
+    juce::File findSamples(const juce::ArgumentList& args)
+    {
+        if (args.containsOption("--samples"))
+            return juce::File::getCurrentWorkingDirectory().getChildFile(args.getValueForOption("--samples"));
+
+        for (auto dir = juce::File::getCurrentWorkingDirectory(); ! dir.isRoot(); dir = dir.getParentDirectory())
+            if (dir.getChildFile("Samples").isDirectory())
+                return dir.getChildFile("Samples");
+
+        return {};
+    }
+
+    struct Reference
+    {
+        juce::File file;
+        juce::AudioBuffer<float> audio;
+        double sampleRate = 0.0;
+    };
+
+    double rmsDb(const juce::AudioBuffer<float>& buffer, int numSamples)
+    {
+        double sum = 0.0;
+
+        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+        {
+            auto* data = buffer.getReadPointer(channel);
+            for (int i = 0; i < numSamples; ++i)
+                sum += (double) data[i] * data[i];
+        }
+
+        auto mean = sum / juce::jmax(1, buffer.getNumChannels() * numSamples);
+        return 10.0 * std::log10(juce::jmax(mean, 1.0e-20));
+    }
+
+    // Empty when the render matches the reference, otherwise what's wrong
+    juce::String check(const Reference& reference, const juce::AudioBuffer<float>& output,
+                       int produced, double sampleRate)
+    {
+        auto refLength = juce::jmax(0, reference.audio.getNumSamples() - tailSlackSamples);
+        auto expected = (int) std::ceil(refLength * sampleRate / reference.sampleRate);
+
+        if (produced < expected)
+            return "rendered " + juce::String(produced) + " of " + juce::String(expected) + " samples";
+
+        if (sampleRate == reference.sampleRate)
+        {
+            float worst = 0.0f;
+
+            for (int channel = 0; channel < output.getNumChannels(); ++channel)
+            {
+                auto* out = output.getReadPointer(channel);
+                auto* ref = reference.audio.getReadPointer(juce::jmin(channel, reference.audio.getNumChannels() - 1));
+
+                for (int i = 0; i < refLength; ++i)
+                    worst = juce::jmax(worst, std::abs(out[i] - ref[i]));
+            }
+
+            if (worst > exactTolerance)
+                return "max error " + juce::String(worst, 6);
+
+            return {};
+        }
+
+        // Resampled: the level has to survive, sample values won't match
+        auto difference = rmsDb(output, expected) - rmsDb(reference.audio, refLength);
+
+        if (std::abs(difference) > rmsToleranceDb)
+            return "RMS off by " + juce::String(difference, 2) + " dB";
+
+        return {};
+    }
+
+    class Report
+    {
+    public:
+        void add(juce::DynamicObject::Ptr entry, const juce::String& line)
+        {
+            std::cout << line << std::endl;
+            entries.add(juce::var(entry.get()));
+        }
+
+        bool write(const juce::File& file, juce::DynamicObject::Ptr summary) const
+        {
+            summary->setProperty("version", ProjectInfo::versionString);
+            summary->setProperty("date", juce::Time::getCurrentTime().toISO8601(true));
+            summary->setProperty("cpu", juce::SystemStats::getCpuModel());
+            summary->setProperty("os", juce::SystemStats::getOperatingSystemName());
+            summary->setProperty("results", entries);
+
+            return file.replaceWithText(juce::JSON::toString(juce::var(summary.get())));
+        }
+
+    private:
+        juce::Array<juce::var> entries;
+    };
+}
+
+int main (int argc, char* argv[])
+{
+    juce::ArgumentList args(argc, argv);
+
+    // The processor starts timers and shared threads, which want a message manager
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    auto samplesDir = findSamples(args);
+    auto rates = parseList(args, "--rates", "44100,48000,96000");
+    auto blockSizes = parseList(args, "--blocks", "32,256,1024");
+    auto maxFiles = args.containsOption("--files") ? args.getValueForOption("--files").getIntValue() : 0;
+
+    auto out = juce::File::getCurrentWorkingDirectory().getChildFile(
+        args.containsOption("--out") ? args.getValueForOption("--out") : juce::String("soundsift_render.json"));
+
+    if (! samplesDir.isDirectory())
+    {
+        std::cerr << "no samples folder; pass --samples=<dir>" << std::endl;
+        return 1;
+    }
+
+    // Reference decodes, through a format manager the processor doesn't share
+    juce::AudioFormatManager formats;
+    formats.registerBasicFormats();
+
+    auto files = samplesDir.findChildFiles(juce::File::findFiles, false, formats.getWildcardForAllFormats());
+    files.sort();
+
+    std::vector<Reference> references;
+
+    for (auto& file : files)
+    {
+        if (maxFiles > 0 && (int) references.size() >= maxFiles)
+            break;
+
+        std::unique_ptr<juce::AudioFormatReader> reader(formats.createReaderFor(file));
+        if (reader == nullptr || reader->lengthInSamples <= 0)
+            continue;
+
+        Reference reference;
+        reference.file = file;
+        reference.sampleRate = reader->sampleRate;
+        reference.audio.setSize((int) reader->numChannels, (int) reader->lengthInSamples);
+        reader->read(&reference.audio, 0, (int) reader->lengthInSamples, 0, true, true);
+        references.push_back(std::move(reference));
+    }
+
+    if (references.empty())
+    {
+        std::cerr << "no readable audio in " << samplesDir.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    std::cout << references.size() << " files from " << samplesDir.getFullPathName() << std::endl;
+
+    SoundSiftAudioProcessor processor;
+    processor.setNonRealtime(true);
+
+    auto numChannels = juce::jmax(processor.getTotalNumInputChannels(), processor.getTotalNumOutputChannels());
+
+    Report report;
+    std::vector<double> coldLoads, warmLoads;
+    std::set<juce::String> loadedOnce;
+    int failures = 0;
+
+    for (auto rate : rates)
+    {
+        for (auto blockSize : blockSizes)
+        {
+            processor.setRateAndBufferSizeDetails(rate, blockSize);
+            processor.prepareToPlay(rate, blockSize);
+
+            juce::AudioBuffer<float> block(numChannels, blockSize);
+            juce::MidiBuffer midi;
+            std::vector<double> blockSeconds;
+            double renderSeconds = 0.0, audioSeconds = 0.0, worstBlock = 0.0;
+            juce::String worstFile;
+            int configFailures = 0;
+
+            for (auto& reference : references)
+            {
+                auto loadStart = juce::Time::getHighResolutionTicks();
+                processor.loadFile(reference.file);
+                auto loadSeconds = secondsSince(loadStart);
+
+                (loadedOnce.insert(reference.file.getFullPathName()).second ? coldLoads : warmLoads).push_back(loadSeconds);
+
+                // Past the expected end by a few blocks, in case the
+                // transport never reports the stream finished
+                auto expected = (int) std::ceil(reference.audio.getNumSamples() * rate / reference.sampleRate);
+                juce::AudioBuffer<float> output(numChannels, expected + 8 * blockSize);
+                output.clear();
+                int produced = 0;
+
+                processor.transportSource.start();
+                auto renderStart = juce::Time::getHighResolutionTicks();
+
+                while (processor.transportSource.isPlaying() && produced + blockSize <= output.getNumSamples())
+                {
+                    block.clear();
+                    midi.clear();
+
+                    auto blockStart = juce::Time::getHighResolutionTicks();
+                    processor.processBlock(block, midi);
+                    auto seconds = secondsSince(blockStart);
+
+                    blockSeconds.push_back(seconds);
+                    if (seconds > worstBlock)
+                    {
+                        worstBlock = seconds;
+                        worstFile = reference.file.getFileName();
+                    }
+
+                    for (int channel = 0; channel < numChannels; ++channel)
+                        output.copyFrom(channel, produced, block, channel, 0, blockSize);
+
+                    produced += blockSize;
+                }
+
+                renderSeconds += secondsSince(renderStart);
+                audioSeconds += produced / (double) rate;
+                processor.transportSource.stop();
+
+                auto problem = check(reference, output, produced, rate);
+                if (problem.isNotEmpty())
+                {
+                    ++configFailures;
+                    std::cerr << "FAIL " << rate << " Hz / " << blockSize << ": "
+                              << reference.file.getFileName() << ": " << problem << std::endl;
+                }
+            }
+
+            processor.releaseResources();
+            failures += configFailures;
+
+            auto deadline = blockSize / (double) rate;
+
+            juce::DynamicObject::Ptr entry = new juce::DynamicObject();
+            entry->setProperty("sample_rate", rate);
+            entry->setProperty("block_size", blockSize);
+            entry->setProperty("files", (int) references.size());
+            entry->setProperty("failures", configFailures);
+            entry->setProperty("realtime_factor", audioSeconds / juce::jmax(renderSeconds, 1.0e-9));
+            entry->setProperty("block_p50_us", percentile(blockSeconds, 0.5) * 1.0e6);
+            entry->setProperty("block_p99_us", percentile(blockSeconds, 0.99) * 1.0e6);
+            entry->setProperty("worst_block_us", worstBlock * 1.0e6);
+            entry->setProperty("worst_block_load", worstBlock / deadline);
+            entry->setProperty("worst_block_file", worstFile);
+
+            juce::String line;
+            line << juce::String(rate).paddedLeft(' ', 6) << " Hz " << juce::String(blockSize).paddedLeft(' ', 5)
+                 << "  x" << juce::String(audioSeconds / juce::jmax(renderSeconds, 1.0e-9), 0) << " realtime"
+                 << "  block p50=" << juce::String(percentile(blockSeconds, 0.5) * 1.0e6, 2) << "us"
+                 << " p99=" << juce::String(percentile(blockSeconds, 0.99) * 1.0e6, 2) << "us"
+                 << " worst=" << juce::String(worstBlock * 1.0e6, 1) << "us ("
+                 << juce::String(100.0 * worstBlock / deadline, 1) << "% of deadline)"
+                 << "  " << (configFailures == 0 ? "ok" : juce::String(configFailures) + " FAILED");
+
+            report.add(entry, line);
+        }
+    }
+
+    auto stats = processor.getPerfMonitor().getStats();
+
+    juce::DynamicObject::Ptr summary = new juce::DynamicObject();
+    summary->setProperty("load_cold_p50_ms", percentile(coldLoads, 0.5) * 1000.0);
+    summary->setProperty("load_cold_max_ms", percentile(coldLoads, 1.0) * 1000.0);
+    summary->setProperty("load_warm_p50_ms", percentile(warmLoads, 0.5) * 1000.0);
+    summary->setProperty("load_warm_max_ms", percentile(warmLoads, 1.0) * 1000.0);
+    summary->setProperty("disk_underruns", (juce::int64) stats.diskUnderruns);
+    summary->setProperty("failures", failures);
+
+    std::cout << "loadFile cold p50=" << juce::String(percentile(coldLoads, 0.5) * 1000.0, 2)
+              << "ms max=" << juce::String(percentile(coldLoads, 1.0) * 1000.0, 2)
+              << "ms, warm p50=" << juce::String(percentile(warmLoads, 0.5) * 1000.0, 3)
+              << "ms max=" << juce::String(percentile(warmLoads, 1.0) * 1000.0, 3) << "ms" << std::endl;
+
+    if (! report.write(out, summary))
+    {
+        std::cerr << "cannot write " << out.getFullPathName() << std::endl;
+        return 1;
+    }
+
+    std::cout << "wrote " << out.getFullPathName() << std::endl;
+    return failures > 0 ? 1 : 0;
+}